@@ -0,0 +1,96 @@
+// Micro-benchmark of the file-name filter kernel.
+//
+// Compares StringMatch::ContainsFolded against the matcher FileBrowser originally used
+// (std::search with a per-character toupper) and against std::string::find over
+// pre-lowered names. Names are synthetic but shaped like a real directory listing.
+
+#include "../src/Core/StringMatch.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The original FileBrowser matcher, kept here as the baseline.
+ */
+static bool StringContainsBaseline(const std::string& haystack, const std::string& needle) {
+    auto it = std::search(
+        haystack.begin(), haystack.end(),
+        needle.begin(), needle.end(),
+        [](char ch1, char ch2) { return std::toupper(ch1) == std::toupper(ch2); }
+    );
+    return (it != haystack.end());
+}
+
+/**
+ * @brief Generates names like "Project_Report 2023 (final) v12.docx".
+ */
+static std::vector<std::string> MakeNames(size_t count) {
+    static const char* words[] = { "Project", "report", "IMG", "Backup", "notes", "Invoice", "setup",
+                                   "Final", "draft", "Photo", "data", "Archive", "résumé", "Übersicht" };
+    static const char* extensions[] = { ".txt", ".docx", ".JPG", ".png", ".zip", ".cpp", ".h", ".log" };
+    std::mt19937 rng(12345);
+    std::vector<std::string> names;
+    names.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        std::string name;
+        int parts = 1 + (int)(rng() % 4);
+        for (int p = 0; p < parts; p++) {
+            if (p) name += (rng() % 2) ? "_" : " ";
+            name += words[rng() % (sizeof(words) / sizeof(words[0]))];
+        }
+        name += " " + std::to_string(rng() % 10000);
+        name += extensions[rng() % (sizeof(extensions) / sizeof(extensions[0]))];
+        names.push_back(std::move(name));
+    }
+    return names;
+}
+
+/**
+ * @brief Runs fn over every name a few times and prints the best ns/name.
+ */
+template <typename Fn>
+static size_t Measure(const char* label, const std::vector<std::string>& names, Fn fn) {
+    size_t matches = 0;
+    double best = 1e30;
+    for (int round = 0; round < 5; round++) {
+        auto start = std::chrono::steady_clock::now();
+        size_t found = 0;
+        for (const auto& name : names) found += fn(name) ? 1 : 0;
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ns);
+        matches = found;
+    }
+    printf("  %-22s %8.2f ns/name  %8zu matches\n", label, best / names.size(), matches);
+    return matches;
+}
+
+int main() {
+    const size_t nameCount = 1000000;
+    std::vector<std::string> names = MakeNames(nameCount);
+    std::vector<std::string> lowered;
+    lowered.reserve(names.size());
+    for (const auto& name : names) lowered.push_back(StringMatch::ToLowerAscii(name));
+
+    printf("StringMatch kernel: %s, %zu names\n", StringMatch::GetKernelName(), nameCount);
+
+    const char* needles[] = { "e", "jpg", "report", "BACKUP_NOTES", "übersicht", "not-present" };
+    bool consistent = true;
+    for (const char* raw : needles) {
+        std::string needle = raw;
+        std::string loweredNeedle = StringMatch::ToLowerAscii(needle);
+        printf("needle \"%s\"\n", raw);
+        size_t a = Measure("std::search+toupper", names, [&](const std::string& n) { return StringContainsBaseline(n, needle); });
+        size_t b = Measure("find on lowered", lowered, [&](const std::string& n) { return n.find(loweredNeedle) != std::string::npos; });
+        size_t c = Measure("ContainsFoldedScalar", names, [&](const std::string& n) { return StringMatch::ContainsFoldedScalar(n, loweredNeedle); });
+        size_t d = Measure("ContainsFolded", names, [&](const std::string& n) { return StringMatch::ContainsFolded(n, loweredNeedle); });
+        if (a != b || b != c || c != d) {
+            printf("  MISMATCH\n");
+            consistent = false;
+        }
+    }
+    return consistent ? 0 : 1;
+}
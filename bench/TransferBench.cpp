@@ -0,0 +1,294 @@
+// End-to-end transfer benchmark.
+//
+// Generates reproducible synthetic trees (fixed seeds, incompressible content) and copies
+// each one headless through TransferManager with several engine configurations. Every
+// run reports files/s, MB/s, p50/p99 per-file latency and peak working set as one JSON
+// object; the whole session is written as a JSON document for regression tracking.
+//
+//   TransferBench <workdir> [--scale X] [--scenario NAME] [--config NAME] [--out FILE]
+//
+// Each run executes in a child process so peak memory is measured per run and no
+// buffer pool or volume cache carries over. Sources are generated once under
+// <workdir>\source and reused; they are usually still in the system cache, so read
+// throughput of the first run after generation is not representative of a cold disk.
+
+#include "../src/Jobs/TransferManager.h"
+#include "../src/Core/Logger.h"
+#include <windows.h>
+#include <psapi.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Shape of a synthetic tree. File sizes are drawn uniformly from each range.
+ */
+struct FileClass {
+    uint64_t count;
+    uint64_t minSize;
+    uint64_t maxSize;
+};
+
+struct Scenario {
+    const char* name;
+    unsigned int folders;  // Folders per level
+    unsigned int depth;    // Nesting levels (1 = flat)
+    std::vector<FileClass> files;
+};
+
+/**
+ * @brief Engine settings a run is measured with.
+ */
+struct Config {
+    const char* name;
+    CopyEngine engine;
+    VerifyMode verify;
+    unsigned int folderConcurrency;
+};
+
+static constexpr uint64_t kKB = 1024;
+static constexpr uint64_t kMB = 1024 * kKB;
+
+static const Scenario kScenarios[] = {
+    { "tiny-files", 100, 1, { { 20000, 512, 8 * kKB } } },
+    { "huge-files", 1, 1, { { 4, 512 * kMB, 512 * kMB } } },
+    { "deep-nesting", 4, 24, { { 4000, 4 * kKB, 64 * kKB } } },
+    { "mixed", 40, 3, { { 10000, 1 * kKB, 64 * kKB }, { 300, 1 * kMB, 16 * kMB }, { 3, 256 * kMB, 256 * kMB } } },
+};
+
+static const Config kConfigs[] = {
+    { "auto", CopyEngine::Auto, VerifyMode::None, 8 },
+    { "auto-serial", CopyEngine::Auto, VerifyMode::None, 1 },
+    { "system", CopyEngine::System, VerifyMode::None, 8 },
+    { "unbuffered", CopyEngine::Unbuffered, VerifyMode::None, 8 },
+    { "auto-verify", CopyEngine::Auto, VerifyMode::ReadBack, 8 },
+};
+
+/**
+ * @brief splitmix64: small, fast and identical on every platform, so trees are reproducible.
+ */
+static uint64_t NextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Folder of the index-th file: spreads files over `folders` branches `depth` levels deep.
+ */
+static fs::path FolderFor(const Scenario& scenario, uint64_t index) {
+    fs::path folder;
+    uint64_t branch = index % scenario.folders;
+    unsigned int level = static_cast<unsigned int>((index / scenario.folders) % scenario.depth);
+    for (unsigned int i = 0; i <= level; i++) folder /= "d" + std::to_string(i == 0 ? branch : i);
+    return folder;
+}
+
+/**
+ * @brief Writes the scenario's tree below root unless a previous run completed it at this scale.
+ * * Sizes and content come from separate generators, so counting a reused tree yields
+ * the same totals without reading it.
+ * @return false if a file could not be written. files and bytes receive the tree's totals.
+ */
+static bool GenerateTree(const Scenario& scenario, double scale, const fs::path& root, uint64_t& files, uint64_t& bytes) {
+    const fs::path marker = root / ".complete";
+    const std::string stamp = "scale " + std::to_string(scale);
+    std::string existing;
+    std::getline(std::ifstream(marker), existing);
+    const bool reuse = (existing == stamp);
+    if (!reuse) {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+        fprintf(stderr, "Generating %s ...\n", scenario.name);
+    }
+
+    uint64_t sizeSeed = 0x5EED0000ull;
+    for (char c : std::string(scenario.name)) sizeSeed = sizeSeed * 31 + static_cast<unsigned char>(c);
+    uint64_t contentSeed = ~sizeSeed;
+    std::vector<uint64_t> block(kMB / sizeof(uint64_t));
+
+    files = bytes = 0;
+    for (size_t c = 0; c < scenario.files.size(); c++) {
+        const FileClass& fileClass = scenario.files[c];
+        const uint64_t count = std::max<uint64_t>(1, static_cast<uint64_t>(fileClass.count * scale));
+        for (uint64_t i = 0; i < count; i++, files++) {
+            uint64_t size = fileClass.minSize;
+            if (fileClass.maxSize > fileClass.minSize) size += NextRandom(sizeSeed) % (fileClass.maxSize - fileClass.minSize + 1);
+            bytes += size;
+            if (reuse) continue;
+
+            const fs::path folder = root / FolderFor(scenario, files);
+            fs::create_directories(folder);
+            std::ofstream out(folder / ("f" + std::to_string(c) + "_" + std::to_string(i) + ".bin"), std::ios::binary);
+            for (uint64_t written = 0; written < size;) {
+                for (auto& word : block) word = NextRandom(contentSeed);
+                const size_t chunk = static_cast<size_t>(std::min<uint64_t>(kMB, size - written));
+                out.write(reinterpret_cast<const char*>(block.data()), chunk);
+                written += chunk;
+            }
+            if (!out) return false;
+        }
+    }
+    if (!reuse) std::ofstream(marker) << stamp << "\n";
+    return true;
+}
+
+static uint64_t Percentile(const std::vector<uint64_t>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+/**
+ * @brief Child mode: copies one scenario with one config and prints a JSON object.
+ * * stdout carries only the result line; the log goes to its file.
+ */
+static int RunOne(const Scenario& scenario, const Config& config, const fs::path& workDir, double scale) {
+    const fs::path source = workDir / "source" / scenario.name;
+    uint64_t files = 0, bytes = 0;
+    if (!GenerateTree(scenario, scale, source, files, bytes)) return 2;
+
+    LoggerOptions logOptions;
+    logOptions.consoleOutput = false;
+    ButlerLogger::Init(logOptions);
+
+    const fs::path target = workDir / "target" / (std::string(scenario.name) + "-" + config.name);
+    std::error_code ec;
+    fs::remove_all(target, ec);
+    fs::create_directories(target);
+
+    std::mutex latencyMutex;
+    std::vector<uint64_t> latencies;
+    latencies.reserve(static_cast<size_t>(files));
+    uint64_t fileFailures = 0;
+
+    double seconds = 0;
+    uint64_t failedJobs = 0;
+    {
+        TransferManager manager(1);
+        manager.SetFolderCopyConcurrency(config.folderConcurrency);
+        manager.SetFileObserver([&](const fs::path&, uint64_t, uint64_t nanoseconds, bool success) {
+            std::lock_guard<std::mutex> lock(latencyMutex);
+            latencies.push_back(nanoseconds);
+            if (!success) fileFailures++;
+        });
+        manager.QueueJob(source, target, JobType::Copy, config.engine, SyncCompare::Metadata, config.verify);
+
+        auto start = std::chrono::steady_clock::now();
+        manager.StartQueue();
+        while (manager.GetCompletedCount() + manager.GetFailedCount() < 1) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        failedJobs = manager.GetFailedCount();
+    }
+
+    ButlerLogger::Shutdown();
+
+    PROCESS_MEMORY_COUNTERS memory{};
+    GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory));
+    fs::remove_all(target, ec);
+
+    std::sort(latencies.begin(), latencies.end());
+    printf("{\"scenario\":\"%s\",\"config\":\"%s\",\"files\":%llu,\"bytes\":%llu,\"seconds\":%.4f,"
+           "\"filesPerSecond\":%.1f,\"mbPerSecond\":%.1f,\"latencyP50Us\":%.1f,\"latencyP99Us\":%.1f,"
+           "\"peakWorkingSetBytes\":%llu,\"failedJobs\":%llu,\"failedFiles\":%llu}\n",
+           scenario.name, config.name, static_cast<unsigned long long>(files), static_cast<unsigned long long>(bytes),
+           seconds, files / seconds, bytes / seconds / kMB, Percentile(latencies, 0.50) / 1000.0,
+           Percentile(latencies, 0.99) / 1000.0, static_cast<unsigned long long>(memory.PeakWorkingSetSize),
+           static_cast<unsigned long long>(failedJobs), static_cast<unsigned long long>(fileFailures));
+    return failedJobs == 0 ? 0 : 1;
+}
+
+/**
+ * @brief Parent mode: runs every selected scenario/config pair in a child and collects the results.
+ */
+static int RunAll(const fs::path& workDir, double scale, const std::string& onlyScenario, const std::string& onlyConfig,
+                  const fs::path& outFile) {
+    wchar_t self[MAX_PATH];
+    GetModuleFileNameW(NULL, self, MAX_PATH);
+
+    std::vector<std::string> results;
+    bool allPassed = true;
+    for (const Scenario& scenario : kScenarios) {
+        if (!onlyScenario.empty() && onlyScenario != scenario.name) continue;
+        uint64_t files = 0, bytes = 0;
+        if (!GenerateTree(scenario, scale, workDir / "source" / scenario.name, files, bytes)) {
+            fprintf(stderr, "Cannot generate %s\n", scenario.name);
+            return 2;
+        }
+        for (const Config& config : kConfigs) {
+            if (!onlyConfig.empty() && onlyConfig != config.name) continue;
+            fprintf(stderr, "%s / %s\n", scenario.name, config.name);
+
+            std::wstring command = L"\"\"" + std::wstring(self) + L"\" --run " + fs::path(scenario.name).wstring() + L" " +
+                                   fs::path(config.name).wstring() + L" \"" + workDir.wstring() + L"\" " +
+                                   std::to_wstring(scale) + L"\"";
+            FILE* child = _wpopen(command.c_str(), L"r");
+            if (!child) return 2;
+            char line[1024];
+            std::string output;
+            while (fgets(line, sizeof(line), child)) {
+                if (line[0] == '{') output = line;
+            }
+            const int status = _pclose(child);
+
+            while (!output.empty() && (output.back() == '\n' || output.back() == '\r')) output.pop_back();
+            if (output.empty()) {
+                fprintf(stderr, "  run failed (exit code %d)\n", status);
+                allPassed = false;
+                continue;
+            }
+            fprintf(stderr, "  %s\n", output.c_str());
+            results.push_back(output);
+            allPassed = allPassed && status == 0;
+        }
+    }
+
+    std::string document = "{\"benchmark\":\"TransferBench\",\"scale\":" + std::to_string(scale) + ",\"runs\":[\n";
+    for (size_t i = 0; i < results.size(); i++) document += "  " + results[i] + (i + 1 < results.size() ? ",\n" : "\n");
+    document += "]}\n";
+    if (outFile.empty()) {
+        fputs(document.c_str(), stdout);
+    } else {
+        std::ofstream(outFile, std::ios::binary) << document;
+    }
+    return allPassed ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 5 && std::string(argv[1]) == "--run") {
+        const Scenario* scenario = nullptr;
+        const Config* config = nullptr;
+        for (const Scenario& s : kScenarios) if (s.name == std::string(argv[2])) scenario = &s;
+        for (const Config& c : kConfigs) if (c.name == std::string(argv[3])) config = &c;
+        if (!scenario || !config) return 2;
+        return RunOne(*scenario, *config, argv[4], argc >= 6 ? atof(argv[5]) : 1.0);
+    }
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: TransferBench <workdir> [--scale X] [--scenario NAME] [--config NAME] [--out FILE]\n");
+        return 2;
+    }
+    fs::path workDir = fs::absolute(argv[1]);
+    double scale = 1.0;
+    std::string onlyScenario, onlyConfig;
+    fs::path outFile;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--scale") scale = std::max(0.001, atof(argv[i + 1]));
+        else if (option == "--scenario") onlyScenario = argv[i + 1];
+        else if (option == "--config") onlyConfig = argv[i + 1];
+        else if (option == "--out") outFile = argv[i + 1];
+    }
+    return RunAll(workDir, scale, onlyScenario, onlyConfig, outFile);
+}
@@ -0,0 +1,185 @@
+#include "BufferPool.h"
+#include <windows.h>
+#include <algorithm>
+#include <utility>
+
+// Buffers without large pages are rounded to the VirtualAlloc allocation granularity.
+static constexpr size_t kAllocationGranularity = 64 * 1024;
+
+// --- BufferLease ---
+
+BufferLease::BufferLease(BufferLease&& other) noexcept
+    : m_pool(std::exchange(other.m_pool, nullptr)), m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)), m_capacity(std::exchange(other.m_capacity, 0)) {}
+
+BufferLease& BufferLease::operator=(BufferLease&& other) noexcept {
+    if (this != &other) {
+        Release();
+        m_pool = std::exchange(other.m_pool, nullptr);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_capacity = std::exchange(other.m_capacity, 0);
+    }
+    return *this;
+}
+
+void BufferLease::Release() {
+    if (m_pool && m_data) m_pool->Return(m_data, m_capacity);
+    m_pool = nullptr;
+    m_data = nullptr;
+    m_size = m_capacity = 0;
+}
+
+// --- BufferPool ---
+
+/**
+ * @brief Returns the process-wide pool (256 MB ceiling until configured otherwise).
+ */
+BufferPool& BufferPool::Shared() {
+    static BufferPool pool;
+    return pool;
+}
+
+BufferPool::BufferPool(size_t memoryLimit) : m_limit(memoryLimit) {}
+
+/**
+ * @brief Frees the cached buffers. All leases must have been returned.
+ */
+BufferPool::~BufferPool() {
+    for (auto& [capacity, data] : m_free) VirtualFree(data, 0, MEM_RELEASE);
+}
+
+/**
+ * @brief Rounds a request up to the granularity new buffers are committed in.
+ */
+size_t BufferPool::RoundCapacity(size_t bytes) const {
+    const size_t granularity = m_largePageSize ? m_largePageSize : kAllocationGranularity;
+    return (std::max<size_t>(bytes, 1) + granularity - 1) / granularity * granularity;
+}
+
+/**
+ * @brief Leases a buffer, reusing a cached one of the same capacity when possible.
+ * * New buffers are committed outside the lock; the bytes are accounted for first, so
+ * concurrent requests cannot overshoot the ceiling together.
+ * * @param bytes Minimum size of the buffer.
+ * @return BufferLease The lease (empty on allocation failure).
+ */
+BufferLease BufferPool::Acquire(size_t bytes) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const size_t capacity = RoundCapacity(bytes);
+    for (;;) {
+        auto cached = m_free.find(capacity);
+        if (cached != m_free.end()) {
+            unsigned char* data = cached->second;
+            m_free.erase(cached);
+            m_leased += capacity;
+            return BufferLease(this, data, bytes, capacity);
+        }
+        if (EvictLocked(capacity) || m_leased == 0) break;
+        m_returned.wait(lock);
+    }
+    m_leased += capacity;
+    m_committed += capacity;
+    const bool largePages = (m_largePageSize != 0);
+    lock.unlock();
+
+    void* data = nullptr;
+    if (largePages) data = VirtualAlloc(NULL, capacity, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+    // Large pages need physically contiguous memory, which fragmentation can rule out
+    if (!data) data = VirtualAlloc(NULL, capacity, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (data) return BufferLease(this, static_cast<unsigned char*>(data), bytes, capacity);
+
+    DWORD error = GetLastError();
+    lock.lock();
+    m_leased -= capacity;
+    m_committed -= capacity;
+    lock.unlock();
+    m_returned.notify_all();
+    SetLastError(error);
+    return BufferLease();
+}
+
+/**
+ * @brief Frees cached buffers until needed more bytes fit under the ceiling.
+ * Must be called with m_mutex held. Frees everything cached if they cannot be made to fit.
+ * @return true if the bytes fit now.
+ */
+bool BufferPool::EvictLocked(size_t needed) {
+    while (m_committed + needed > m_limit && !m_free.empty()) {
+        // Largest first: frees the most memory with the fewest calls
+        auto victim = std::prev(m_free.end());
+        VirtualFree(victim->second, 0, MEM_RELEASE);
+        m_committed -= victim->first;
+        m_free.erase(victim);
+    }
+    return m_committed + needed <= m_limit;
+}
+
+/**
+ * @brief Takes a buffer back from a lease and wakes waiting requests.
+ * * The buffer is cached for reuse unless the pool is over its ceiling (after the ceiling
+ * was lowered, or an oversized grant), in which case it is freed.
+ */
+void BufferPool::Return(unsigned char* data, size_t capacity) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_leased -= capacity;
+        if (m_committed > m_limit) {
+            VirtualFree(data, 0, MEM_RELEASE);
+            m_committed -= capacity;
+        } else {
+            m_free.emplace(capacity, data);
+        }
+    }
+    m_returned.notify_all();
+}
+
+void BufferPool::SetMemoryLimit(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_limit = bytes;
+        EvictLocked(0);
+    }
+    m_returned.notify_all();
+}
+
+size_t BufferPool::GetMemoryLimit() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_limit;
+}
+
+size_t BufferPool::GetLeasedBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_leased;
+}
+
+size_t BufferPool::GetCommittedBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_committed;
+}
+
+/**
+ * @brief Enables SeLockMemoryPrivilege for the process and switches new buffers to large pages.
+ * * The privilege has to be granted to the account ("Lock pages in memory"); enabling it
+ * only activates it for this process. Cached buffers keep their normal pages.
+ * * @return true if large pages are in use.
+ */
+bool BufferPool::EnableLargePages() {
+    const SIZE_T largePage = GetLargePageMinimum();
+    if (largePage == 0) return false;
+
+    HANDLE token = NULL;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) return false;
+    TOKEN_PRIVILEGES privileges{};
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    bool granted = LookupPrivilegeValueW(NULL, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) &&
+                   AdjustTokenPrivileges(token, FALSE, &privileges, 0, NULL, NULL) &&
+                   GetLastError() == ERROR_SUCCESS; // ERROR_NOT_ALL_ASSIGNED: the account lacks it
+    CloseHandle(token);
+    if (!granted) return false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_largePageSize = largePage;
+    return true;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+
+class BufferPool;
+
+/**
+ * @brief A buffer leased from a BufferPool; returned to the pool when destroyed.
+ * * The memory is page aligned (large-page aligned when large pages are in use), which
+ * satisfies the sector alignment of FILE_FLAG_NO_BUFFERING.
+ */
+class BufferLease {
+public:
+    BufferLease() = default;
+    ~BufferLease() { Release(); }
+
+    BufferLease(BufferLease&& other) noexcept;
+    BufferLease& operator=(BufferLease&& other) noexcept;
+    BufferLease(const BufferLease&) = delete;
+    BufferLease& operator=(const BufferLease&) = delete;
+
+    unsigned char* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+    explicit operator bool() const { return m_data != nullptr; }
+
+    /**
+     * @brief Hands the buffer back early. The lease is empty afterwards.
+     */
+    void Release();
+
+private:
+    friend class BufferPool;
+    BufferLease(BufferPool* pool, unsigned char* data, size_t size, size_t capacity)
+        : m_pool(pool), m_data(data), m_size(size), m_capacity(capacity) {}
+
+    BufferPool* m_pool = nullptr;
+    unsigned char* m_data = nullptr;
+    size_t m_size = 0;     // Bytes requested
+    size_t m_capacity = 0; // Bytes committed (rounded to the allocation granularity)
+};
+
+/**
+ * @brief Process-wide pool of aligned transfer buffers under a memory ceiling.
+ * * Every copy engine leases its I/O buffers here instead of allocating them per file.
+ * Released buffers are kept and handed to the next request of the same size, so the
+ * hot path does not allocate. The bytes committed by the pool (leased plus cached) never
+ * exceed the ceiling: a request that does not fit first evicts cached buffers, then waits
+ * until other leases are returned. Peak memory is therefore fixed by the ceiling, not by
+ * the number of jobs running.
+ * * A request larger than the whole ceiling is still granted once nothing else is leased,
+ * so an oversized configuration degrades to one transfer at a time instead of deadlocking.
+ * Callers must hold at most one lease at a time for the same reason.
+ */
+class BufferPool {
+public:
+    /**
+     * @brief The pool shared by all transfers.
+     */
+    static BufferPool& Shared();
+
+    explicit BufferPool(size_t memoryLimit = 256ull * 1024 * 1024);
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * @brief Leases a buffer of at least bytes, blocking while the ceiling is reached.
+     * @return The lease; empty only if the system is out of memory (GetLastError() is set).
+     */
+    BufferLease Acquire(size_t bytes);
+
+    /**
+     * @brief Changes the ceiling. Cached buffers above a lowered ceiling are freed at once;
+     * leases already granted are not revoked.
+     */
+    void SetMemoryLimit(size_t bytes);
+    size_t GetMemoryLimit() const;
+
+    /**
+     * @brief Allows large pages for new buffers. Needs SeLockMemoryPrivilege; returns false
+     * (and keeps using normal pages) if the account does not hold it.
+     */
+    bool EnableLargePages();
+    bool UsesLargePages() const { return m_largePageSize != 0; }
+
+    size_t GetLeasedBytes() const;
+    size_t GetCommittedBytes() const;
+
+private:
+    friend class BufferLease;
+    void Return(unsigned char* data, size_t capacity);
+    bool EvictLocked(size_t needed);
+    size_t RoundCapacity(size_t bytes) const;
+
+    size_t m_limit;
+    size_t m_leased = 0;    // Bytes held by leases
+    size_t m_committed = 0; // Leased + cached bytes
+    size_t m_largePageSize = 0;
+    std::multimap<size_t, unsigned char*> m_free; // Cached buffers by capacity
+    mutable std::mutex m_mutex;
+    std::condition_variable m_returned;
+};
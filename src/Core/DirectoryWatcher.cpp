@@ -0,0 +1,223 @@
+#include "DirectoryWatcher.h"
+#include <windows.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+// Size of the notification buffer. 64 KB is the largest size that works over SMB.
+static constexpr DWORD kNotifyBufferBytes = 64 * 1024;
+
+/**
+ * @brief State shared between a DirectoryWatcher and its detached watch thread.
+ * * The thread keeps its own reference, so the owner can drop the watch at any time
+ * (even while the directory handle is still being opened on a slow share).
+ */
+struct WatchState {
+    std::filesystem::path path;
+    HANDLE stopEvent = NULL;
+    HANDLE armedEvent = NULL; // Set once the first read is issued, or when the watch fails
+    std::atomic<bool> failed{ false };
+
+    std::mutex mutex;
+    std::vector<DirectoryChange> changes; // Guarded by mutex
+    bool overflowed = false;              // Guarded by mutex
+
+    ~WatchState() {
+        if (stopEvent) CloseHandle(stopEvent);
+        if (armedEvent) CloseHandle(armedEvent);
+    }
+};
+
+/**
+ * @brief Builds a change record for one notification, stat-ing the item if it should exist.
+ * * Items that vanished again before the stat are reported as removed.
+ */
+static DirectoryChange MakeChange(const std::filesystem::path& dir, DWORD action, std::wstring name) {
+    DirectoryChange change;
+    change.name = std::move(name);
+
+    if (action == FILE_ACTION_REMOVED || action == FILE_ACTION_RENAMED_OLD_NAME) {
+        change.kind = DirectoryChange::Kind::Remove;
+        return change;
+    }
+
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW((dir / change.name).c_str(), GetFileExInfoStandard, &data)) {
+        change.kind = DirectoryChange::Kind::Remove;
+        return change;
+    }
+    change.kind = DirectoryChange::Kind::Upsert;
+    change.attributes = data.dwFileAttributes;
+    change.isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    change.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    change.lastWriteTime = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+    return change;
+}
+
+/**
+ * @brief Body of the detached watch thread.
+ * * Issues overlapped ReadDirectoryChangesW calls and waits on the completion event and
+ * the stop event. A zero-byte completion means the kernel buffer overflowed.
+ * * @param state Shared state; kept alive by this thread until it returns.
+ */
+static void RunWatcher(std::shared_ptr<WatchState> state) {
+    HANDLE dir = CreateFileW(state->path.c_str(), FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    HANDLE ioEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (dir == INVALID_HANDLE_VALUE || !ioEvent) {
+        state->failed = true;
+        SetEvent(state->armedEvent);
+        if (dir != INVALID_HANDLE_VALUE) CloseHandle(dir);
+        if (ioEvent) CloseHandle(ioEvent);
+        return;
+    }
+
+    // FILE_NOTIFY_INFORMATION records must be DWORD-aligned.
+    std::vector<DWORD> buffer(kNotifyBufferBytes / sizeof(DWORD));
+    const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                         FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+
+    while (true) {
+        OVERLAPPED ov{};
+        ov.hEvent = ioEvent;
+        ResetEvent(ioEvent);
+        if (!ReadDirectoryChangesW(dir, buffer.data(), kNotifyBufferBytes, FALSE, filter, NULL, &ov, NULL)) {
+            state->failed = true;
+            SetEvent(state->armedEvent);
+            break;
+        }
+        // From here on the handle buffers changes between reads, so none is missed
+        SetEvent(state->armedEvent);
+
+        HANDLE handles[2] = { ioEvent, state->stopEvent };
+        DWORD bytes = 0;
+        if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0) {
+            CancelIoEx(dir, &ov);
+            GetOverlappedResult(dir, &ov, &bytes, TRUE);
+            break;
+        }
+
+        bool overflow = false;
+        if (!GetOverlappedResult(dir, &ov, &bytes, FALSE)) {
+            if (GetLastError() != ERROR_NOTIFY_ENUM_DIR) {
+                state->failed = true; // Directory deleted, share disconnected, ...
+                break;
+            }
+            overflow = true;
+        } else if (bytes == 0) {
+            overflow = true;
+        }
+
+        std::vector<DirectoryChange> batch;
+        if (!overflow) {
+            const BYTE* cursor = reinterpret_cast<const BYTE*>(buffer.data());
+            while (true) {
+                const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(cursor);
+                std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                batch.push_back(MakeChange(state->path, info->Action, std::move(name)));
+                if (info->NextEntryOffset == 0) break;
+                cursor += info->NextEntryOffset;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (overflow) state->overflowed = true;
+        for (auto& change : batch) state->changes.push_back(std::move(change));
+    }
+
+    CloseHandle(ioEvent);
+    CloseHandle(dir);
+}
+
+/**
+ * @brief Signals the watch thread to exit.
+ */
+DirectoryWatcher::~DirectoryWatcher() {
+    Stop();
+}
+
+/**
+ * @brief Takes over another watcher's watch; changes gathered so far stay pending.
+ */
+DirectoryWatcher::DirectoryWatcher(DirectoryWatcher&& other) noexcept
+    : m_path(std::move(other.m_path)), m_state(std::move(other.m_state)) {
+    other.m_path.clear();
+}
+
+/**
+ * @brief Stops the current watch and takes over another watcher's watch.
+ */
+DirectoryWatcher& DirectoryWatcher::operator=(DirectoryWatcher&& other) noexcept {
+    if (this != &other) {
+        Stop();
+        m_path = std::move(other.m_path);
+        m_state = std::move(other.m_state);
+        other.m_path.clear();
+    }
+    return *this;
+}
+
+/**
+ * @brief Replaces the watched directory.
+ * * @param dir The directory to watch.
+ */
+void DirectoryWatcher::Watch(const std::filesystem::path& dir) {
+    Stop();
+    m_path = dir;
+    m_state = std::make_shared<WatchState>();
+    m_state->path = dir;
+    m_state->stopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    m_state->armedEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!m_state->stopEvent || !m_state->armedEvent) {
+        m_state->failed = true;
+        return;
+    }
+    std::thread(RunWatcher, m_state).detach();
+}
+
+/**
+ * @brief Tells the current watch thread to exit and forgets it.
+ */
+void DirectoryWatcher::Stop() {
+    if (m_state && m_state->stopEvent) SetEvent(m_state->stopEvent);
+    m_state.reset();
+    m_path.clear();
+}
+
+/**
+ * @brief Hands out the changes collected since the previous call.
+ * * @param out Receives the changes in the order they were reported.
+ * @return false if some notifications were lost.
+ */
+bool DirectoryWatcher::DrainChanges(std::vector<DirectoryChange>& out) {
+    if (!m_state) return true;
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    for (auto& change : m_state->changes) out.push_back(std::move(change));
+    m_state->changes.clear();
+    bool complete = !m_state->overflowed;
+    m_state->overflowed = false;
+    return complete;
+}
+
+DirectoryWatcher::ArmToken DirectoryWatcher::GetArmToken() const {
+    ArmToken token;
+    token.m_state = m_state;
+    return token;
+}
+
+/**
+ * @brief Blocks the calling thread until the watch thread armed its first read.
+ * * A watch that failed (or could not be created) counts as not armed.
+ */
+bool DirectoryWatcher::ArmToken::Wait(uint32_t timeoutMs) const {
+    if (!m_state || !m_state->armedEvent) return false;
+    return WaitForSingleObject(m_state->armedEvent, timeoutMs) == WAIT_OBJECT_0 && !m_state->failed;
+}
+
+/**
+ * @brief Reports whether the current watch could not be established or broke down.
+ */
+bool DirectoryWatcher::Failed() const {
+    return !m_state || m_state->failed;
+}
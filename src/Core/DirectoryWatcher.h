@@ -0,0 +1,95 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+/**
+ * @brief One change reported for a watched directory.
+ * * The watcher thread already stat-ed the item, so applying an Upsert never touches
+ * the filesystem on the caller's thread.
+ */
+struct DirectoryChange {
+    enum class Kind {
+        Upsert, // Created, renamed into place or modified; metadata below is current
+        Remove  // Deleted or renamed away
+    };
+
+    Kind kind = Kind::Upsert;
+    std::wstring name; // File name relative to the watched directory
+    bool isDirectory = false;
+    uint64_t size = 0;
+    uint64_t lastWriteTime = 0; // FILETIME as 100 ns ticks since 1601
+    uint32_t attributes = 0;
+};
+
+struct WatchState;
+
+/**
+ * @brief Watches a single directory (non-recursively) with ReadDirectoryChangesW.
+ * * Notifications are collected on a background thread and handed out in batches
+ * through DrainChanges(), so the owner can apply them at most once per frame.
+ */
+class DirectoryWatcher {
+public:
+    DirectoryWatcher() = default;
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+    DirectoryWatcher(DirectoryWatcher&& other) noexcept;
+    DirectoryWatcher& operator=(DirectoryWatcher&& other) noexcept;
+
+    /**
+     * @brief Starts watching dir, replacing any previously watched directory.
+     * Never blocks: the old watch is cancelled and the new one opened in the background.
+     */
+    void Watch(const std::filesystem::path& dir);
+
+    /**
+     * @brief Stops watching.
+     */
+    void Stop();
+
+    /**
+     * @brief Moves every change gathered since the last call into out (appending).
+     * @return false if notifications were lost (buffer overflow) and the owner should re-list.
+     */
+    bool DrainChanges(std::vector<DirectoryChange>& out);
+
+    /**
+     * @brief Returns true if the directory could not be watched (e.g. unsupported filesystem).
+     */
+    bool Failed() const;
+
+    const std::filesystem::path& GetPath() const { return m_path; }
+
+    /**
+     * @brief Lets another thread wait until the watch is armed, i.e. the first
+     * ReadDirectoryChangesW call is in place and every later change will be reported.
+     * Keeps the watch state alive on its own, so it may outlive the watcher.
+     */
+    class ArmToken {
+    public:
+        /**
+         * @brief Waits until the watch is armed or has failed, at most timeoutMs.
+         * @return true if the watch is armed. An empty token returns false at once.
+         */
+        bool Wait(uint32_t timeoutMs) const;
+
+    private:
+        friend class DirectoryWatcher;
+        std::shared_ptr<WatchState> m_state;
+    };
+
+    /**
+     * @brief Returns a token for the current watch (an empty one if nothing is watched).
+     */
+    ArmToken GetArmToken() const;
+
+private:
+    std::filesystem::path m_path;
+    std::shared_ptr<WatchState> m_state;
+};
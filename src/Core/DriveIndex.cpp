@@ -0,0 +1,364 @@
+#include "DriveIndex.h"
+#include "Logger.h"
+#include "StringMatch.h"
+#include <windows.h>
+#include <winioctl.h>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+// Output buffer for one FSCTL_ENUM_USN_DATA call.
+static constexpr DWORD kEnumBufferBytes = 1024 * 1024;
+
+// Upper bound on walk threads; more only adds seek contention on a single volume.
+static constexpr unsigned int kMaxWalkThreads = 8;
+
+// Guards against corrupt parent chains when rebuilding a path.
+static constexpr int kMaxPathDepth = 1024;
+
+/**
+ * @brief Collects the distinct trigram keys of a name, with ASCII letters folded to lower case.
+ * * @param keys Cleared, then filled with sorted, unique keys.
+ */
+static void CollectTrigrams(const char* text, size_t length, std::vector<uint32_t>& keys) {
+    auto fold = [](char c) { return (uint32_t)(unsigned char)((c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c); };
+    keys.clear();
+    for (size_t i = 0; i + 3 <= length; i++) {
+        keys.push_back(fold(text[i]) << 16 | fold(text[i + 1]) << 8 | fold(text[i + 2]));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+/**
+ * @brief Returns the live index of a drive or starts a new one.
+ * * Only a weak reference is kept here, so an index is freed once no browser uses it.
+ * * @param driveLetter The drive to index (e.g. 'C').
+ */
+std::shared_ptr<DriveIndex> DriveIndex::Acquire(char driveLetter) {
+    static std::mutex registryMutex;
+    static std::map<char, std::weak_ptr<DriveIndex>> registry;
+
+    driveLetter = (char)toupper((unsigned char)driveLetter);
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::shared_ptr<DriveIndex> index = registry[driveLetter].lock();
+    if (!index) {
+        index = std::make_shared<DriveIndex>(driveLetter);
+        registry[driveLetter] = index;
+    }
+    return index;
+}
+
+/**
+ * @brief Launches the build thread.
+ * * @param driveLetter The drive to index.
+ */
+DriveIndex::DriveIndex(char driveLetter) : m_drive(driveLetter) {
+    m_thread = std::thread(&DriveIndex::BuildLoop, this);
+}
+
+/**
+ * @brief Cancels an unfinished build and waits for the thread to exit.
+ */
+DriveIndex::~DriveIndex() {
+    m_cancel = true;
+    if (m_thread.joinable()) m_thread.join();
+}
+
+/**
+ * @brief Thread body: collects every name, then builds the trigram index.
+ * * The MFT enumeration is tried first; if the volume is not NTFS or the process is not
+ * elevated, the tree is walked instead.
+ */
+void DriveIndex::BuildLoop() {
+    if (!BuildFromMft()) {
+        m_nodes.clear();
+        m_names.clear();
+        m_indexedCount = 0;
+        BuildFromWalk();
+    }
+    if (m_cancel) return;
+
+    BuildTrigrams();
+    if (m_cancel) return;
+
+    m_ready = true;
+    ButlerLogger::Log(LogLevel::INFO, "Indexed {} entries on {}: ({})", m_nodes.size(), m_drive,
+                      m_usedMft ? "MFT" : "directory walk");
+}
+
+/**
+ * @brief Appends one name to the arena and the node table.
+ * * @param name UTF-16 name (not necessarily null-terminated).
+ * @param length Length of name in characters.
+ * @param parent Parent node, or kNoParent if not known yet.
+ * @return uint32_t The index of the new node.
+ */
+uint32_t DriveIndex::AddNode(const wchar_t* name, size_t length, uint32_t parent, bool isDirectory) {
+    Node node;
+    node.nameOffset = (uint32_t)m_names.size();
+    node.parent = parent;
+    node.isDirectory = isDirectory ? 1 : 0;
+
+    int bytes = length ? WideCharToMultiByte(CP_UTF8, 0, name, (int)length, NULL, 0, NULL, NULL) : 0;
+    m_names.resize(m_names.size() + bytes);
+    if (bytes > 0) WideCharToMultiByte(CP_UTF8, 0, name, (int)length, &m_names[node.nameOffset], bytes, NULL, NULL);
+    node.nameLength = (uint16_t)bytes;
+
+    m_nodes.push_back(node);
+    m_indexedCount++;
+    return (uint32_t)(m_nodes.size() - 1);
+}
+
+/**
+ * @brief Reads every file record of an NTFS volume through FSCTL_ENUM_USN_DATA.
+ * * Records arrive in MFT order, so parents are linked up by file reference number
+ * once the enumeration is complete. Records whose parent chain does not reach the root
+ * (metadata files under $Extend) are kept but never returned by Search().
+ * * @return false if the MFT cannot be read; the caller then falls back to a walk.
+ */
+bool DriveIndex::BuildFromMft() {
+    wchar_t root[] = L"X:\\";
+    root[0] = (wchar_t)m_drive;
+    wchar_t fsName[MAX_PATH + 1] = L"";
+    if (!GetVolumeInformationW(root, NULL, 0, NULL, NULL, NULL, fsName, MAX_PATH + 1) || wcscmp(fsName, L"NTFS") != 0) {
+        return false;
+    }
+
+    // File reference number of the root directory, which anchors every path
+    HANDLE rootDir = CreateFileW(root, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+        OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+    if (rootDir == INVALID_HANDLE_VALUE) return false;
+    BY_HANDLE_FILE_INFORMATION rootInfo;
+    BOOL gotRoot = GetFileInformationByHandle(rootDir, &rootInfo);
+    CloseHandle(rootDir);
+    if (!gotRoot) return false;
+    const uint64_t rootFrn = (static_cast<uint64_t>(rootInfo.nFileIndexHigh) << 32) | rootInfo.nFileIndexLow;
+
+    wchar_t volumePath[] = L"\\\\.\\X:";
+    volumePath[4] = (wchar_t)m_drive;
+    HANDLE volume = CreateFileW(volumePath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+    if (volume == INVALID_HANDLE_VALUE) return false; // Usually: not elevated
+
+    MFT_ENUM_DATA_V0 query{};
+    query.StartFileReferenceNumber = 0;
+    query.LowUsn = 0;
+    query.HighUsn = MAXLONGLONG;
+    USN_JOURNAL_DATA_V0 journal;
+    DWORD bytes = 0;
+    if (DeviceIoControl(volume, FSCTL_QUERY_USN_JOURNAL, NULL, 0, &journal, sizeof(journal), &bytes, NULL)) {
+        query.HighUsn = journal.NextUsn;
+    }
+
+    std::vector<uint64_t> parentFrns; // Parallel to m_nodes until parents are resolved
+    std::unordered_map<uint64_t, uint32_t> nodeByFrn;
+    AddNode(L"", 0, kNoParent, true);
+    parentFrns.push_back(0);
+    nodeByFrn[rootFrn] = 0;
+
+    std::vector<uint64_t> buffer(kEnumBufferBytes / sizeof(uint64_t)); // Records are 8-byte aligned
+    BYTE* base = reinterpret_cast<BYTE*>(buffer.data());
+    bool ok = true;
+    while (!m_cancel) {
+        if (!DeviceIoControl(volume, FSCTL_ENUM_USN_DATA, &query, sizeof(query), base, kEnumBufferBytes, &bytes, NULL)) {
+            ok = (GetLastError() == ERROR_HANDLE_EOF); // EOF marks the end of the MFT
+            break;
+        }
+        if (bytes <= sizeof(USN)) break;
+
+        // The buffer starts with the reference number to resume from, followed by records
+        const BYTE* cursor = base + sizeof(USN);
+        const BYTE* end = base + bytes;
+        while (cursor < end) {
+            const auto* record = reinterpret_cast<const USN_RECORD_V2*>(cursor);
+            if (record->RecordLength == 0) break;
+            if (record->MajorVersion == 2 && record->FileReferenceNumber != rootFrn) {
+                const auto* name = reinterpret_cast<const wchar_t*>(cursor + record->FileNameOffset);
+                bool isDirectory = (record->FileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+                nodeByFrn[record->FileReferenceNumber] =
+                    AddNode(name, record->FileNameLength / sizeof(wchar_t), kNoParent, isDirectory);
+                parentFrns.push_back(record->ParentFileReferenceNumber);
+            }
+            cursor += record->RecordLength;
+        }
+        query.StartFileReferenceNumber = *reinterpret_cast<const DWORDLONG*>(base);
+    }
+    CloseHandle(volume);
+    if (!ok) return false;
+
+    for (size_t i = 1; i < m_nodes.size(); i++) {
+        auto it = nodeByFrn.find(parentFrns[i]);
+        m_nodes[i].parent = (it != nodeByFrn.end()) ? it->second : kNoParent;
+    }
+    m_usedMft = true;
+    return true;
+}
+
+/**
+ * @brief Walks the volume with several threads sharing one stack of directories.
+ * * Each thread lists a directory without holding the lock, then appends the names and
+ * pushes the subdirectories in one locked step. Reparse-point directories are indexed
+ * but not descended into. Directories that cannot be listed are skipped.
+ */
+void DriveIndex::BuildFromWalk() {
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::vector<std::pair<std::wstring, uint32_t>> pending; // Directory path and its node
+    unsigned int busy = 0;
+
+    AddNode(L"", 0, kNoParent, true);
+    pending.emplace_back(std::wstring(1, (wchar_t)m_drive) + L":", 0);
+
+    struct Found {
+        std::wstring name;
+        bool isDirectory;
+        bool descend;
+    };
+
+    auto worker = [&]() {
+        std::vector<Found> found;
+        while (true) {
+            std::pair<std::wstring, uint32_t> dir;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                workAvailable.wait(lock, [&] { return !pending.empty() || busy == 0 || m_cancel; });
+                if (pending.empty() || m_cancel) {
+                    workAvailable.notify_all(); // Let the other threads see the walk is over
+                    return;
+                }
+                dir = std::move(pending.back());
+                pending.pop_back();
+                busy++;
+            }
+
+            found.clear();
+            WIN32_FIND_DATAW data;
+            HANDLE find = FindFirstFileExW((dir.first + L"\\*").c_str(), FindExInfoBasic, &data,
+                FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+            if (find != INVALID_HANDLE_VALUE) {
+                do {
+                    if (wcscmp(data.cFileName, L".") == 0 || wcscmp(data.cFileName, L"..") == 0) continue;
+                    bool isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+                    bool isReparse = (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+                    found.push_back({ data.cFileName, isDirectory, isDirectory && !isReparse });
+                } while (FindNextFileW(find, &data));
+                FindClose(find);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (const auto& f : found) {
+                    uint32_t node = AddNode(f.name.c_str(), f.name.size(), dir.second, f.isDirectory);
+                    if (f.descend) pending.emplace_back(dir.first + L"\\" + f.name, node);
+                }
+                busy--;
+            }
+            workAvailable.notify_all();
+        }
+    };
+
+    unsigned int threadCount = std::clamp(std::thread::hardware_concurrency(), 2u, kMaxWalkThreads);
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < threadCount; i++) threads.emplace_back(worker);
+    for (auto& t : threads) t.join();
+}
+
+/**
+ * @brief Builds the trigram posting lists in two passes (count, then fill).
+ * * Postings of one trigram end up in ascending node order, stored back to back in a
+ * single vector, so the index costs four bytes per (name, distinct trigram) pair.
+ */
+void DriveIndex::BuildTrigrams() {
+    std::vector<uint32_t> keys;
+    for (size_t i = 1; i < m_nodes.size() && !m_cancel; i++) {
+        CollectTrigrams(&m_names[m_nodes[i].nameOffset], m_nodes[i].nameLength, keys);
+        for (uint32_t key : keys) m_trigrams[key].count++;
+    }
+
+    uint32_t offset = 0;
+    for (auto& [key, posting] : m_trigrams) {
+        posting.offset = offset;
+        offset += posting.count;
+        posting.count = 0;
+    }
+    m_postings.resize(offset);
+
+    for (size_t i = 1; i < m_nodes.size() && !m_cancel; i++) {
+        CollectTrigrams(&m_names[m_nodes[i].nameOffset], m_nodes[i].nameLength, keys);
+        for (uint32_t key : keys) {
+            Posting& posting = m_trigrams[key];
+            m_postings[posting.offset + posting.count++] = (uint32_t)i;
+        }
+    }
+}
+
+/**
+ * @brief Rebuilds the full path of a node by following its parents to the root.
+ * * @return std::filesystem::path The path, or empty if the node is not reachable from the root.
+ */
+std::filesystem::path DriveIndex::GetPath(uint32_t node) const {
+    std::vector<uint32_t> chain;
+    while (node != 0) {
+        if (node == kNoParent || chain.size() >= kMaxPathDepth) return {};
+        chain.push_back(node);
+        node = m_nodes[node].parent;
+    }
+
+    std::string utf8 = std::string(1, m_drive) + ":";
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        utf8 += '\\';
+        utf8.append(m_names, m_nodes[*it].nameOffset, m_nodes[*it].nameLength);
+    }
+
+    int length = MultiByteToWideChar(CP_UTF8, 0, utf8.data(), (int)utf8.size(), NULL, 0);
+    std::wstring wide(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, utf8.data(), (int)utf8.size(), wide.data(), length);
+    return std::filesystem::path(wide);
+}
+
+/**
+ * @brief Finds entries whose name contains the needle.
+ * * Needles of three or more bytes only verify the entries listed under their rarest
+ * trigram; shorter needles fall back to a linear scan of the name arena.
+ * * @param needle Text to look for (case-insensitive for ASCII letters).
+ * @param maxResults Maximum number of paths to return.
+ * @return std::vector<std::filesystem::path> Matching paths, in index order.
+ */
+std::vector<std::filesystem::path> DriveIndex::Search(std::string_view needle, size_t maxResults) const {
+    std::vector<std::filesystem::path> results;
+    if (!m_ready || needle.empty() || maxResults == 0) return results;
+
+    std::string lowered = StringMatch::ToLowerAscii(needle);
+    std::string_view arena(m_names);
+
+    // Returns false once enough results were collected
+    auto consider = [&](uint32_t i) {
+        const Node& node = m_nodes[i];
+        if (!StringMatch::ContainsFolded(arena.substr(node.nameOffset, node.nameLength), lowered)) return true;
+        std::filesystem::path path = GetPath(i);
+        if (!path.empty()) results.push_back(std::move(path));
+        return results.size() < maxResults;
+    };
+
+    if (lowered.size() < 3) {
+        for (uint32_t i = 1; i < (uint32_t)m_nodes.size(); i++) {
+            if (!consider(i)) break;
+        }
+        return results;
+    }
+
+    std::vector<uint32_t> keys;
+    CollectTrigrams(lowered.data(), lowered.size(), keys);
+    const Posting* rarest = nullptr;
+    for (uint32_t key : keys) {
+        auto it = m_trigrams.find(key);
+        if (it == m_trigrams.end()) return results; // Some trigram occurs nowhere
+        if (!rarest || it->second.count < rarest->count) rarest = &it->second;
+    }
+
+    for (uint32_t k = 0; k < rarest->count; k++) {
+        if (!consider(m_postings[rarest->offset + k])) break;
+    }
+    return results;
+}
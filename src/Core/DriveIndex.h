@@ -0,0 +1,97 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief A searchable index of every file and directory name on one volume.
+ * * Built once on a background thread: on NTFS the MFT is enumerated directly with
+ * FSCTL_ENUM_USN_DATA (needs administrator rights); otherwise the volume is walked
+ * with several threads. Names live in one contiguous arena and a trigram index maps
+ * every three-byte sequence of a case-folded name to the entries containing it, so a
+ * query only verifies (with StringMatch) the entries of its rarest trigram.
+ * * The index is a snapshot: it is not updated afterwards. Results may therefore name
+ * files that have since been deleted.
+ */
+class DriveIndex {
+public:
+    /**
+     * @brief Returns the index of a drive, starting a build if none is alive.
+     * Browsers searching the same drive share one index.
+     */
+    static std::shared_ptr<DriveIndex> Acquire(char driveLetter);
+
+    /**
+     * @brief Starts indexing the volume of driveLetter in the background.
+     */
+    explicit DriveIndex(char driveLetter);
+
+    /**
+     * @brief Cancels an unfinished build and joins the thread.
+     */
+    ~DriveIndex();
+
+    DriveIndex(const DriveIndex&) = delete;
+    DriveIndex& operator=(const DriveIndex&) = delete;
+
+    bool IsReady() const { return m_ready; }
+    bool UsedMft() const { return m_usedMft; }
+    char GetDrive() const { return m_drive; }
+
+    /**
+     * @brief Number of names indexed so far (updated while building).
+     */
+    uint64_t GetIndexedCount() const { return m_indexedCount; }
+
+    /**
+     * @brief Finds entries whose name contains needle (ASCII case-insensitive).
+     * Returns nothing until IsReady().
+     * @param needle The text to look for.
+     * @param maxResults Stops after this many matches.
+     */
+    std::vector<std::filesystem::path> Search(std::string_view needle, size_t maxResults) const;
+
+private:
+    /**
+     * @brief One indexed name. The root directory is node 0.
+     */
+    struct Node {
+        uint32_t nameOffset;  // Into m_names
+        uint32_t parent;      // Node index, or kNoParent for entries outside the tree
+        uint16_t nameLength;  // Bytes of UTF-8
+        uint16_t isDirectory;
+    };
+
+    struct Posting {
+        uint32_t offset; // Into m_postings
+        uint32_t count;
+    };
+
+    static constexpr uint32_t kNoParent = 0xFFFFFFFFu;
+
+    void BuildLoop();
+    bool BuildFromMft();
+    void BuildFromWalk();
+    void BuildTrigrams();
+    uint32_t AddNode(const wchar_t* name, size_t length, uint32_t parent, bool isDirectory);
+    std::filesystem::path GetPath(uint32_t node) const;
+
+    char m_drive;
+    std::vector<Node> m_nodes;
+    std::string m_names; // UTF-8 names, back to back
+    std::vector<uint32_t> m_postings;
+    std::unordered_map<uint32_t, Posting> m_trigrams;
+
+    std::atomic<uint64_t> m_indexedCount{ 0 };
+    std::atomic<bool> m_ready{ false };
+    std::atomic<bool> m_usedMft{ false };
+    std::atomic<bool> m_cancel{ false };
+    std::thread m_thread;
+};
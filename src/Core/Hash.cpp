@@ -0,0 +1,264 @@
+#include "Hash.h"
+#include "ThreadPool.h"
+#include "BufferPool.h"
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+static constexpr uint64_t kPrime1 = 11400714785074694791ull;
+static constexpr uint64_t kPrime2 = 14029467366897019727ull;
+static constexpr uint64_t kPrime3 = 1609587929392839161ull;
+static constexpr uint64_t kPrime4 = 9650029242287828579ull;
+static constexpr uint64_t kPrime5 = 2870177450012600261ull;
+
+// ChunkedDigest::HashFile reads kHashBuffers blocks of kHashReadSize (a multiple of the chunk size).
+static constexpr DWORD kHashReadSize = 4 * ChunkedDigest::kChunkSize;
+static constexpr size_t kHashBuffers = 4;
+
+static inline uint64_t RotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t Read64(const unsigned char* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t Read32(const unsigned char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Mixes one 8-byte lane into an accumulator.
+ */
+static inline uint64_t Round(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = RotateLeft(acc, 31);
+    return acc * kPrime1;
+}
+
+static inline uint64_t MergeRound(uint64_t acc, uint64_t value) {
+    acc ^= Round(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+/**
+ * @brief Resets the state to hash a new message.
+ * * @param seed Seed of the hash (0 for the standard value).
+ */
+void Xxh64::Reset(uint64_t seed) {
+    m_seed = seed;
+    m_acc[0] = seed + kPrime1 + kPrime2;
+    m_acc[1] = seed + kPrime2;
+    m_acc[2] = seed;
+    m_acc[3] = seed - kPrime1;
+    m_totalLength = 0;
+    m_buffered = 0;
+}
+
+/**
+ * @brief Feeds more bytes into the hash.
+ * * Whole 32-byte stripes are consumed directly from the input; a trailing partial
+ * stripe is kept until the next call or Digest().
+ */
+void Xxh64::Update(const void* data, size_t length) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + length;
+    m_totalLength += length;
+
+    if (m_buffered + length < 32) {
+        memcpy(m_buffer + m_buffered, p, length);
+        m_buffered += length;
+        return;
+    }
+
+    if (m_buffered > 0) {
+        size_t fill = 32 - m_buffered;
+        memcpy(m_buffer + m_buffered, p, fill);
+        p += fill;
+        for (int lane = 0; lane < 4; lane++) m_acc[lane] = Round(m_acc[lane], Read64(m_buffer + lane * 8));
+        m_buffered = 0;
+    }
+
+    for (; p + 32 <= end; p += 32) {
+        m_acc[0] = Round(m_acc[0], Read64(p));
+        m_acc[1] = Round(m_acc[1], Read64(p + 8));
+        m_acc[2] = Round(m_acc[2], Read64(p + 16));
+        m_acc[3] = Round(m_acc[3], Read64(p + 24));
+    }
+
+    m_buffered = static_cast<size_t>(end - p);
+    if (m_buffered > 0) memcpy(m_buffer, p, m_buffered);
+}
+
+/**
+ * @brief Returns the hash of everything fed so far. The state is left unchanged.
+ */
+uint64_t Xxh64::Digest() const {
+    uint64_t h;
+    if (m_totalLength >= 32) {
+        h = RotateLeft(m_acc[0], 1) + RotateLeft(m_acc[1], 7) + RotateLeft(m_acc[2], 12) + RotateLeft(m_acc[3], 18);
+        for (int lane = 0; lane < 4; lane++) h = MergeRound(h, m_acc[lane]);
+    } else {
+        h = m_seed + kPrime5;
+    }
+    h += m_totalLength;
+
+    const unsigned char* p = m_buffer;
+    const unsigned char* end = m_buffer + m_buffered;
+    for (; p + 8 <= end; p += 8) {
+        h ^= Round(0, Read64(p));
+        h = RotateLeft(h, 27) * kPrime1 + kPrime4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(Read32(p)) * kPrime1;
+        h = RotateLeft(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= (*p) * kPrime5;
+        h = RotateLeft(h, 11) * kPrime1;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+/**
+ * @brief One-shot hash of a buffer.
+ */
+uint64_t Xxh64::Hash(const void* data, size_t length, uint64_t seed) {
+    Xxh64 state(seed);
+    state.Update(data, length);
+    return state.Digest();
+}
+
+/**
+ * @brief Sizes the chunk table for a file of totalBytes.
+ */
+void ChunkedDigest::Reset(uint64_t totalBytes) {
+    m_chunks.assign(static_cast<size_t>((totalBytes + kChunkSize - 1) / kChunkSize), 0);
+}
+
+/**
+ * @brief Hashes every chunk of a chunk-aligned range into its slot.
+ * * Each call writes only the slots of its own chunks, so disjoint ranges can be added
+ * from several threads without locking.
+ */
+void ChunkedDigest::AddRange(uint64_t offset, const void* data, size_t length) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    size_t index = static_cast<size_t>(offset / kChunkSize);
+    for (size_t done = 0; done < length && index < m_chunks.size(); done += kChunkSize, index++) {
+        m_chunks[index] = Xxh64::Hash(p + done, std::min(kChunkSize, length - done));
+    }
+}
+
+/**
+ * @brief Hashes the list of chunk hashes into the final digest.
+ */
+uint64_t ChunkedDigest::Combine(const std::vector<uint64_t>& chunkHashes) {
+    return Xxh64::Hash(chunkHashes.data(), chunkHashes.size() * sizeof(uint64_t));
+}
+
+/**
+ * @brief Computes the digest of a file.
+ * * Blocks are read sequentially into a small ring of page-aligned buffers (aligned
+ * for FILE_FLAG_NO_BUFFERING) leased from the shared BufferPool. With a pool, each filled buffer is hashed there while
+ * the next ones are read, so hashing overlaps the I/O; a buffer is only reused once
+ * its hash task has finished.
+ * * @param path File to hash.
+ * @param digest Receives the digest.
+ * @param pool Hash threads, or nullptr to hash on the calling thread.
+ * @param bypassCache Read around the system cache.
+ * @param onBlock Progress/cancel callback, may be empty.
+ * @return true on success.
+ */
+bool ChunkedDigest::HashFile(const std::filesystem::path& path, uint64_t& digest, ThreadPool* pool,
+                             bool bypassCache, const std::function<bool(uint64_t)>& onBlock) {
+    HANDLE file = INVALID_HANDLE_VALUE;
+    if (bypassCache) {
+        file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                           FILE_FLAG_NO_BUFFERING, NULL);
+    }
+    const bool unbuffered = (file != INVALID_HANDLE_VALUE);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    }
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        DWORD error = GetLastError();
+        CloseHandle(file);
+        SetLastError(error);
+        return false;
+    }
+
+    BufferLease lease = BufferPool::Shared().Acquire(kHashReadSize * kHashBuffers);
+    BYTE* arena = lease.Data();
+    if (!arena) {
+        DWORD error = GetLastError();
+        CloseHandle(file);
+        SetLastError(error);
+        return false;
+    }
+
+    ChunkedDigest state(static_cast<uint64_t>(size.QuadPart));
+    std::atomic<bool> hashing[kHashBuffers] = {};
+    auto waitFor = [&](size_t slot) {
+        while (hashing[slot].load()) hashing[slot].wait(true);
+    };
+
+    uint64_t offset = 0;
+    DWORD error = ERROR_SUCCESS;
+    for (size_t slot = 0;; slot = (slot + 1) % kHashBuffers) {
+        waitFor(slot);
+        BYTE* buffer = arena + slot * kHashReadSize;
+
+        DWORD filled = 0;
+        while (filled < kHashReadSize) {
+            DWORD bytes = 0;
+            if (!ReadFile(file, buffer + filled, kHashReadSize - filled, &bytes, NULL)) { error = GetLastError(); break; }
+            if (bytes == 0) break;
+            filled += bytes;
+            // Unbuffered reads must stay sector-sized, so a short one can only mean end of file.
+            if (unbuffered && filled < kHashReadSize) break;
+        }
+        if (error != ERROR_SUCCESS || filled == 0) break;
+
+        if (pool) {
+            hashing[slot] = true;
+            pool->Submit([&state, &hashing, slot, buffer, offset, filled] {
+                state.AddRange(offset, buffer, filled);
+                hashing[slot] = false;
+                hashing[slot].notify_all();
+            });
+        } else {
+            state.AddRange(offset, buffer, filled);
+        }
+        offset += filled;
+
+        if (onBlock && !onBlock(offset)) { error = ERROR_REQUEST_ABORTED; break; }
+        if (filled < kHashReadSize) break; // End of file
+    }
+
+    for (size_t slot = 0; slot < kHashBuffers; slot++) waitFor(slot);
+    lease.Release();
+    CloseHandle(file);
+
+    if (error != ERROR_SUCCESS) {
+        SetLastError(error);
+        return false;
+    }
+    digest = state.Finish();
+    return true;
+}
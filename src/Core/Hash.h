@@ -0,0 +1,85 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+/**
+ * @brief Streaming XXH64, a fast non-cryptographic 64-bit hash.
+ * * Used to compare file contents; it detects accidental differences, not deliberate
+ * collisions. Output matches the reference xxHash implementation.
+ */
+class Xxh64 {
+public:
+    explicit Xxh64(uint64_t seed = 0) { Reset(seed); }
+
+    void Reset(uint64_t seed = 0);
+    void Update(const void* data, size_t length);
+    uint64_t Digest() const;
+
+    /**
+     * @brief Hashes one buffer in a single call.
+     */
+    static uint64_t Hash(const void* data, size_t length, uint64_t seed = 0);
+
+private:
+    uint64_t m_acc[4];
+    uint64_t m_seed;
+    uint64_t m_totalLength;
+    unsigned char m_buffer[32]; // Bytes of an incomplete stripe
+    size_t m_buffered;
+};
+
+/**
+ * @brief Digest of a file built from independent chunks: the XXH64 of the XXH64s of every
+ * 1 MB chunk.
+ * * Chunks can be hashed in any order and on several threads at once, so hashing keeps up
+ * with multi-GB/s streams. The result depends only on the content, which makes a digest
+ * taken while copying comparable with one taken by reading the copy back.
+ */
+class ChunkedDigest {
+public:
+    static constexpr size_t kChunkSize = 1024 * 1024;
+
+    explicit ChunkedDigest(uint64_t totalBytes = 0) { Reset(totalBytes); }
+
+    /**
+     * @brief Prepares for a file of totalBytes; data past that length is ignored.
+     */
+    void Reset(uint64_t totalBytes);
+
+    /**
+     * @brief Hashes the chunks covering [offset, offset + length).
+     * offset must be a multiple of kChunkSize and length one too unless the range ends the file.
+     * Concurrent calls are safe as long as their ranges do not overlap.
+     */
+    void AddRange(uint64_t offset, const void* data, size_t length);
+
+    uint64_t Finish() const { return Combine(m_chunks); }
+
+    /**
+     * @brief Folds per-chunk XXH64 values (in file order) into the digest.
+     */
+    static uint64_t Combine(const std::vector<uint64_t>& chunkHashes);
+
+    /**
+     * @brief Reads a file and returns its digest.
+     * @param path File to read.
+     * @param digest Receives the digest.
+     * @param pool Optional; chunks are hashed there while the next block is being read.
+     * @param bypassCache Read with FILE_FLAG_NO_BUFFERING so the data comes from the device
+     * rather than the system cache (falls back to cached reads if the volume refuses).
+     * @param onBlock Optional; called after each block with the bytes read so far.
+     * Returning false stops hashing (the call then fails with ERROR_REQUEST_ABORTED).
+     * @return true on success, false with GetLastError() set otherwise.
+     */
+    static bool HashFile(const std::filesystem::path& path, uint64_t& digest, ThreadPool* pool = nullptr,
+                         bool bypassCache = false, const std::function<bool(uint64_t)>& onBlock = nullptr);
+
+private:
+    std::vector<uint64_t> m_chunks;
+};
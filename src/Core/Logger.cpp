@@ -1,19 +1,154 @@
 #include "Logger.h"
 #include <iostream>
 #include <ctime>
-#include <iomanip>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <cstdint>
 
 std::ofstream ButlerLogger::m_logFile;
 std::mutex ButlerLogger::m_logMutex;
+LoggerOptions ButlerLogger::m_options;
+std::atomic<bool> ButlerLogger::m_async{ false };
+
+// The writer hands at most this many messages to the file per write call.
+static constexpr size_t kMaxWriteBatch = 256;
+
+/**
+ * @brief Bounded multi-producer / single-consumer queue of formatted log lines.
+ * * Every slot carries a sequence number (Vyukov's bounded queue), so producers claim a
+ * slot with a single CAS and never block each other or the writer.
+ */
+class LogRing {
+public:
+    void Reset(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        m_slots = std::make_unique<Slot[]>(size);
+        for (size_t i = 0; i < size; i++) m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        m_mask = size - 1;
+        m_enqueuePos.store(0, std::memory_order_relaxed);
+        m_dequeuePos = 0;
+    }
+
+    // Moves line into the queue. Returns false (leaving line untouched) if the queue is full.
+    bool TryPush(std::string& line) {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = m_slots[pos & m_mask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.line.swap(line);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Writer only: appends the oldest line (plus a newline) to out.
+    bool TryPop(std::string& out) {
+        Slot& slot = m_slots[m_dequeuePos & m_mask];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if ((intptr_t)sequence - (intptr_t)(m_dequeuePos + 1) < 0) return false;
+        out += slot.line;
+        out += '\n';
+        slot.line.clear();
+        slot.sequence.store(m_dequeuePos + m_mask + 1, std::memory_order_release);
+        m_dequeuePos++;
+        return true;
+    }
+
+    bool Empty() const {
+        const Slot& slot = m_slots[m_dequeuePos & m_mask];
+        return (intptr_t)slot.sequence.load(std::memory_order_acquire) - (intptr_t)(m_dequeuePos + 1) < 0;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{ 0 };
+        std::string line;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask = 0;
+    std::atomic<size_t> m_enqueuePos{ 0 };
+    size_t m_dequeuePos = 0; // Only touched by the writer
+};
+
+// Async state. Producers only touch the ring and the wake flags.
+static LogRing g_ring;
+static std::thread g_writer;
+static std::atomic<bool> g_stopWriter{ false };
+static std::atomic<bool> g_writerSleeping{ false };
+static std::atomic<uint64_t> g_flushRequests{ 0 };   // Tickets taken by ERR lines that must reach the disk
+static std::atomic<uint64_t> g_flushedRequests{ 0 };  // Highest ticket the writer has flushed
+static std::mutex g_wakeMutex;
+static std::condition_variable g_wakeWriter;
+static std::atomic<int64_t> g_lastInlineFlushMs{ 0 }; // Periodic flushing of inline writes
+static std::atomic<int> g_activeProducers{ 0 };        // Threads inside CommitLine's async path
+
+// Per-thread line buffer; its capacity is reused (and traded with ring slots) across messages.
+static thread_local std::string t_line;
+
+/**
+ * @brief Appends "[YYYY-MM-DD HH:MM:SS] " to out.
+ * * The text is cached per thread and only re-formatted when the second changes, so the
+ * common case is a time() call and a short copy.
+ */
+static void AppendTimeStamp(std::string& out) {
+    thread_local std::time_t cachedSecond = -1;
+    thread_local char cached[32];
+    thread_local size_t cachedLength = 0;
+
+    std::time_t now = std::time(nullptr);
+    if (now != cachedSecond) {
+        std::tm localTime;
+        localtime_s(&localTime, &now); // Thread-safe version of localtime
+        cachedLength = std::strftime(cached, sizeof(cached), "[%Y-%m-%d %H:%M:%S] ", &localTime);
+        cachedSecond = now;
+    }
+    out.append(cached, cachedLength);
+}
+
+/**
+ * @brief Wakes the writer thread, taking the wake mutex only if it is actually asleep.
+ * * The fence orders the producer's push before its read of g_writerSleeping. It pairs with
+ * the fence in WriterLoop: either the producer sees the flag set or the writer sees the
+ * pushed line, so a line can never sit in the ring while the writer sleeps.
+ */
+static void WakeWriter() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (g_writerSleeping.load(std::memory_order_relaxed) && g_writerSleeping.exchange(false)) {
+        std::lock_guard<std::mutex> lock(g_wakeMutex);
+        g_wakeWriter.notify_one();
+    }
+}
+
+/**
+ * @brief Stops the writer at process exit if Shutdown() was never called (e.g. early returns).
+ */
+static struct WriterGuard {
+    ~WriterGuard() { ButlerLogger::Shutdown(); }
+} g_writerGuard;
 
 /**
  * @brief Initializes the logging subsystem.
  * * This function checks for the existence of the "logs" directory and creates it if missing.
  * It then opens the "sysbutler_core.log" file in append mode and writes a session start header.
- * Thread-safety is ensured via a mutex.
+ * In async mode the background writer thread is started last.
+ * * @param options Write mode, console echo and flush policy.
  */
-void ButlerLogger::Init() {
+void ButlerLogger::Init(const LoggerOptions& options) {
     std::lock_guard<std::mutex> lock(m_logMutex);
+    m_options = options;
     
     // Create logs directory if it doesn't exist
     std::filesystem::path logDir("logs");
@@ -27,30 +162,177 @@ void ButlerLogger::Init() {
     if (m_logFile.is_open()) {
         m_logFile << "\n=== SysButler Session Started: " << GetTimeStamp() << " ===\n";
     }
+
+    if (m_options.async && !g_writer.joinable()) {
+        g_ring.Reset(m_options.queueCapacity);
+        g_stopWriter = false;
+        g_writer = std::thread(&ButlerLogger::WriterLoop);
+        m_async = true;
+    }
 }
 
 /**
- * @brief Writes a formatted log message to the log file and standard console.
- * * The message is prefixed with a current timestamp and the severity level.
- * The output is flushed immediately to ensure logs are captured even in the event of a crash.
+ * @brief Writes everything still queued and stops the writer thread.
+ * * Safe to call more than once. Messages logged afterwards are written synchronously,
+ * so late log calls (e.g. from destructors) are not lost.
+ */
+void ButlerLogger::Shutdown() {
+    if (!g_writer.joinable()) return;
+    m_async = false;
+    // Let producers that saw m_async still set finish their push while the writer runs
+    while (g_activeProducers.load() != 0) std::this_thread::yield();
+    g_stopWriter = true;
+    {
+        std::lock_guard<std::mutex> lock(g_wakeMutex);
+        g_writerSleeping = false;
+        g_wakeWriter.notify_one();
+    }
+    g_writer.join();
+
+    // Producers that raced with the switch to synchronous mode
+    std::string rest;
+    while (g_ring.TryPop(rest)) {}
+    WriteBatch(rest, true);
+}
+
+/**
+ * @brief Writes a block of complete lines to the log file (and console) under the file lock.
+ * * @param text One or more newline-terminated lines.
+ * @param flush Whether to flush the streams afterwards.
+ */
+void ButlerLogger::WriteBatch(const std::string& text, bool flush) {
+    std::lock_guard<std::mutex> lock(m_logMutex);
+    if (!text.empty()) {
+        if (m_logFile.is_open()) m_logFile.write(text.data(), (std::streamsize)text.size());
+        if (m_options.consoleOutput) std::cout.write(text.data(), (std::streamsize)text.size());
+    }
+    if (flush) {
+        if (m_logFile.is_open()) m_logFile.flush();
+        if (m_options.consoleOutput) std::cout.flush();
+    }
+}
+
+/**
+ * @brief Body of the async writer thread.
+ * * Drains the ring in batches and writes each batch with one call. Flushes when an ERR
+ * message asked for it or when the flush interval elapsed, then sleeps until a producer
+ * wakes it or the next periodic flush is due. The flush ticket is read before draining:
+ * its line was pushed first, so once the ring is empty it has been written and the
+ * ticket can be handed back to the waiting producer.
+ */
+void ButlerLogger::WriterLoop() {
+    using Clock = std::chrono::steady_clock;
+    const auto interval = std::chrono::milliseconds(m_options.flushIntervalMs);
+    auto lastFlush = Clock::now();
+    bool unflushed = false;
+    uint64_t flushedTicket = g_flushedRequests.load();
+    std::string batch;
+
+    auto releaseTicket = [&](uint64_t ticket) {
+        flushedTicket = ticket;
+        g_flushedRequests = ticket;
+        g_flushedRequests.notify_all();
+    };
+
+    while (true) {
+        const uint64_t requested = g_flushRequests.load();
+        batch.clear();
+        size_t count = 0;
+        while (count < kMaxWriteBatch && g_ring.TryPop(batch)) count++;
+
+        bool flush = requested != flushedTicket || interval.count() == 0 ||
+                     (unflushed && Clock::now() - lastFlush >= interval);
+        if (count > 0 || flush) {
+            WriteBatch(batch, flush);
+            unflushed = !flush && (unflushed || count > 0);
+            if (flush) lastFlush = Clock::now();
+            if (flush && count < kMaxWriteBatch && requested != flushedTicket) releaseTicket(requested);
+        }
+        if (count == kMaxWriteBatch) continue; // More is waiting
+
+        if (g_stopWriter) {
+            if (g_ring.Empty()) break;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(g_wakeMutex);
+        g_writerSleeping = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst); // Pairs with WakeWriter()
+        if (!g_ring.Empty() || g_flushRequests.load() != flushedTicket) {
+            g_writerSleeping = false;
+            continue;
+        }
+        auto wakeAt = unflushed ? lastFlush + interval : Clock::now() + std::chrono::hours(1);
+        g_wakeWriter.wait_until(lock, wakeAt, [] { return !g_writerSleeping || g_stopWriter; });
+        g_writerSleeping = false;
+    }
+
+    WriteBatch(std::string(), true);
+    releaseTicket(g_flushRequests.load());
+}
+
+/**
+ * @brief Writes a log message to the log file and standard console.
+ * * The message is prefixed with a current timestamp and the severity level; see CommitLine()
+ * for how it is written.
  * * @param level The severity level of the log (DEBUG, INFO, WARN, ERR).
  * @param message The content string to log.
  */
-void ButlerLogger::Log(LogLevel level, const std::string& message) {
-    std::lock_guard<std::mutex> lock(m_logMutex);
-    
-    std::string timestamp = GetTimeStamp();
-    std::string levelStr = LevelToString(level);
-    std::string finalMsg = "[" + timestamp + "] [" + levelStr + "] " + message;
+void ButlerLogger::Log(LogLevel level, std::string_view message) {
+    if (level < kMinLogLevel) return;
+    BeginLine(level).append(message);
+    CommitLine(level);
+}
 
-    // Write to file
-    if (m_logFile.is_open()) {
-        m_logFile << finalMsg << std::endl;
-        m_logFile.flush(); // Ensure it writes immediately
+/**
+ * @brief Starts a new line in the calling thread's buffer with the timestamp and level prefix.
+ * * @return std::string& The buffer; the caller appends the message text.
+ */
+std::string& ButlerLogger::BeginLine(LogLevel level) {
+    t_line.clear();
+    AppendTimeStamp(t_line);
+    t_line += '[';
+    t_line.append(LevelToString(level));
+    t_line += "] ";
+    return t_line;
+}
+
+/**
+ * @brief Hands the line started by BeginLine() to the writer or writes it inline.
+ * * In async mode the line is swapped into the ring buffer (the thread gets the slot's
+ * old buffer back, so steady-state logging does not allocate) and the caller returns
+ * without touching the file; if the ring is full the caller waits for the writer to make
+ * room, so no message is dropped. In sync mode (or before Init / after Shutdown) the line
+ * is written inline. With flushOnError, an ERR caller also waits until the writer has
+ * written and flushed its line, so the message survives a crash right after the call.
+ */
+void ButlerLogger::CommitLine(LogLevel level) {
+    const bool flushNow = (level == LogLevel::ERR && m_options.flushOnError);
+
+    // Registered before m_async is read, so Shutdown() waits for this push to land
+    // before it drains the ring for the last time.
+    g_activeProducers++;
+    while (m_async) {
+        if (g_ring.TryPush(t_line)) {
+            // Still counted as a producer while waiting, so Shutdown() keeps the writer running
+            const uint64_t ticket = flushNow ? ++g_flushRequests : 0;
+            WakeWriter();
+            for (uint64_t done; (done = g_flushedRequests.load()) < ticket;) g_flushedRequests.wait(done);
+            g_activeProducers--;
+            return;
+        }
+        WakeWriter(); // Full: let the writer catch up
+        std::this_thread::yield();
     }
+    g_activeProducers--;
 
-    // Also write to standard console for debug visibility
-    std::cout << finalMsg << std::endl;
+    // Inline write (sync mode, or the writer is not running)
+    using namespace std::chrono;
+    const int64_t nowMs = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+    bool flush = flushNow || nowMs - g_lastInlineFlushMs >= (int64_t)m_options.flushIntervalMs;
+    if (flush) g_lastInlineFlushMs = nowMs;
+    t_line += '\n';
+    WriteBatch(t_line, flush);
 }
 
 /**
@@ -61,18 +343,18 @@ std::string ButlerLogger::GetTimeStamp() {
     std::time_t now = std::time(nullptr);
     std::tm localTime;
     localtime_s(&localTime, &now); // Thread-safe version of localtime
-    
-    std::ostringstream oss;
-    oss << std::put_time(&localTime, "%Y-%m-%d %H:%M:%S");
-    return oss.str();
+
+    char buffer[32];
+    size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &localTime);
+    return std::string(buffer, length);
 }
 
 /**
  * @brief Converts the LogLevel enum to a readable string representation.
  * * @param level The log level to convert.
- * @return std::string The string representation (e.g., "INFO ", "ERROR").
+ * @return std::string_view The string representation (e.g., "INFO ", "ERROR"), never allocated.
  */
-std::string ButlerLogger::LevelToString(LogLevel level) {
+std::string_view ButlerLogger::LevelToString(LogLevel level) {
     switch (level) {
         case LogLevel::DEBUG: return "DEBUG";
         case LogLevel::INFO:  return "INFO ";
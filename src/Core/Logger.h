@@ -1,9 +1,13 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <mutex>
+#include <atomic>
 #include <filesystem>
+#include <format>
+#include <iterator>
 
 enum class LogLevel {
     DEBUG,
@@ -12,20 +16,66 @@ enum class LogLevel {
     ERR  // "ERROR" is often a macro in Windows headers, so we use ERR
 };
 
+// Messages below this level are discarded before formatting. Release builds drop DEBUG unless
+// BUTLER_LOG_MIN_LEVEL is defined (0 = DEBUG, 1 = INFO, 2 = WARN, 3 = ERR).
+#ifndef BUTLER_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define BUTLER_LOG_MIN_LEVEL 1
+#else
+#define BUTLER_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+inline constexpr LogLevel kMinLogLevel = static_cast<LogLevel>(BUTLER_LOG_MIN_LEVEL);
+
+/**
+ * @brief How the logger writes and flushes.
+ */
+struct LoggerOptions {
+    bool async = true;             // Queue messages for a background writer instead of writing inline
+    bool consoleOutput = true;     // Also echo every message to std::cout
+    bool flushOnError = true;      // ERR messages are on disk by the time Log() returns
+    unsigned flushIntervalMs = 1000; // Other messages are flushed at least this often (0 = every message)
+    size_t queueCapacity = 4096;   // Async ring buffer slots, rounded up to a power of two
+};
+
 class ButlerLogger {
 public:
-    // Initialize the logger (opens file, creates directory)
-    static void Init();
+    // Initialize the logger (opens file, creates directory, starts the writer in async mode)
+    static void Init(const LoggerOptions& options = LoggerOptions());
+
+    // Drains queued messages and stops the writer; later messages are written inline
+    static void Shutdown();
     
     // Main log function
-    static void Log(LogLevel level, const std::string& message);
+    static void Log(LogLevel level, std::string_view message);
     
     // Overload to log simple strings easily
-    static void Log(const std::string& message) { Log(LogLevel::INFO, message); }
+    static void Log(std::string_view message) { Log(LogLevel::INFO, message); }
+
+    /**
+     * @brief Logs a std::format message, e.g. Log(LogLevel::INFO, "Copied {} of {}", done, total).
+     * Formats straight into a reused per-thread line buffer, so no temporary strings are built.
+     * Calls below kMinLogLevel return before anything is formatted.
+     */
+    template <typename... Args>
+        requires (sizeof...(Args) > 0)
+    static void Log(LogLevel level, std::format_string<Args...> fmt, Args&&... args) {
+        if (level < kMinLogLevel) return;
+        std::string& line = BeginLine(level);
+        std::format_to(std::back_inserter(line), fmt, std::forward<Args>(args)...);
+        CommitLine(level);
+    }
 
 private:
     static std::ofstream m_logFile;
     static std::mutex m_logMutex;
+    static LoggerOptions m_options;
+    static std::atomic<bool> m_async;
     static std::string GetTimeStamp();
-    static std::string LevelToString(LogLevel level);
-};
\ No newline at end of file
+    static std::string_view LevelToString(LogLevel level);
+    static std::string& BeginLine(LogLevel level);
+    static void CommitLine(LogLevel level);
+    static void WriteBatch(const std::string& text, bool flush);
+    static void WriterLoop();
+};
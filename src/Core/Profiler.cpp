@@ -0,0 +1,267 @@
+#include "Profiler.h"
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static const char* kStageNames[kProfileStageCount] = {
+    "Scan", "Create", "Read", "Write", "SystemCopy", "Verify", "Delete", "Refresh", "Listing", "Frame"
+};
+
+namespace {
+
+struct TraceEvent {
+    uint64_t start;
+    uint64_t end;
+    uint64_t bytes;
+    ProfileStage stage;
+};
+
+/**
+ * @brief A block of spans. The owning thread fills it and publishes each span by bumping
+ * `used` (release); readers only look at the first `used` entries.
+ */
+struct TraceChunk {
+    static constexpr size_t kCapacity = 4096;
+    TraceEvent events[kCapacity];
+    std::atomic<size_t> used{ 0 };
+    std::atomic<TraceChunk*> next{ nullptr };
+};
+
+struct StageCounters {
+    std::atomic<uint64_t> count{ 0 };
+    std::atomic<uint64_t> totalNs{ 0 };
+    std::atomic<uint64_t> maxNs{ 0 };
+    std::atomic<uint64_t> bytes{ 0 };
+    std::atomic<uint64_t> histogram[kProfileBuckets] = {};
+};
+
+/**
+ * @brief Counters and spans of one thread. Only the owning thread writes them.
+ */
+struct ThreadProfile {
+    DWORD threadId = 0;
+    StageCounters stages[kProfileStageCount];
+    // Spans of trace number traceGeneration; both are only changed under g_mutex
+    std::atomic<TraceChunk*> firstChunk{ nullptr };
+    uint64_t traceGeneration = 0;
+    TraceChunk* lastChunk = nullptr; // Owner only
+};
+
+struct RetiredTrace {
+    DWORD threadId;
+    TraceChunk* firstChunk;
+};
+
+// Guards the thread list, the totals of exited threads and the lifetime of trace chunks.
+std::mutex g_mutex;
+std::vector<ThreadProfile*> g_threads;
+ProfileSnapshot g_retired;
+std::vector<RetiredTrace> g_retiredTraces; // Spans of exited threads, current trace only
+
+std::atomic<bool> g_tracing{ false };
+std::atomic<uint64_t> g_traceGeneration{ 0 };
+std::atomic<int64_t> g_traceBudget{ 0 }; // Spans the current trace may still keep
+uint64_t g_traceOrigin = 0;              // Now() at StartTrace; guarded by g_mutex
+
+void FreeChunks(TraceChunk* chunk) {
+    while (chunk) {
+        TraceChunk* next = chunk->next.load();
+        delete chunk;
+        chunk = next;
+    }
+}
+
+void AddCounters(ProfileStageStats& into, const StageCounters& from) {
+    into.count += from.count.load(std::memory_order_relaxed);
+    into.totalNs += from.totalNs.load(std::memory_order_relaxed);
+    into.maxNs = std::max(into.maxNs, from.maxNs.load(std::memory_order_relaxed));
+    into.bytes += from.bytes.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kProfileBuckets; i++) into.histogram[i] += from.histogram[i].load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Registers the thread's profile on first use and folds it into the totals at thread exit.
+ */
+struct ThreadProfileOwner {
+    ThreadProfile* profile = nullptr;
+
+    ThreadProfile& Get() {
+        if (!profile) {
+            profile = new ThreadProfile;
+            profile->threadId = GetCurrentThreadId();
+            std::lock_guard<std::mutex> lock(g_mutex);
+            g_threads.push_back(profile);
+        }
+        return *profile;
+    }
+
+    ~ThreadProfileOwner() {
+        if (!profile) return;
+        TraceChunk* stale = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            for (size_t i = 0; i < kProfileStageCount; i++) AddCounters(g_retired[i], profile->stages[i]);
+            TraceChunk* chunks = profile->firstChunk.load();
+            if (profile->traceGeneration == g_traceGeneration.load()) {
+                if (chunks) g_retiredTraces.push_back({ profile->threadId, chunks });
+            } else {
+                stale = chunks;
+            }
+            g_threads.erase(std::find(g_threads.begin(), g_threads.end(), profile));
+        }
+        FreeChunks(stale);
+        delete profile;
+    }
+};
+
+thread_local ThreadProfileOwner t_profile;
+
+/**
+ * @brief Keeps one span in the calling thread's chunks.
+ */
+void AppendSpan(ThreadProfile& profile, ProfileStage stage, uint64_t startNs, uint64_t endNs, uint64_t bytes) {
+    const uint64_t generation = g_traceGeneration.load(std::memory_order_acquire);
+    if (profile.traceGeneration != generation) {
+        // First span of a new trace: drop the previous trace's spans. Detached under the
+        // lock, so an export cannot be reading them while they are freed.
+        TraceChunk* stale = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            stale = profile.firstChunk.exchange(nullptr);
+            profile.traceGeneration = generation;
+        }
+        profile.lastChunk = nullptr;
+        FreeChunks(stale);
+    }
+    if (g_traceBudget.fetch_sub(1, std::memory_order_relaxed) <= 0) return;
+
+    TraceChunk* chunk = profile.lastChunk;
+    if (!chunk || chunk->used.load(std::memory_order_relaxed) == TraceChunk::kCapacity) {
+        auto* fresh = new TraceChunk;
+        if (chunk) chunk->next.store(fresh, std::memory_order_release);
+        else profile.firstChunk.store(fresh, std::memory_order_release);
+        profile.lastChunk = chunk = fresh;
+    }
+    const size_t index = chunk->used.load(std::memory_order_relaxed);
+    chunk->events[index] = TraceEvent{ startNs, endNs, bytes, stage };
+    chunk->used.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Single-writer increment: the owner is the only thread storing to these counters.
+ */
+inline void Bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+} // namespace
+
+/**
+ * @brief Adds one sample to the calling thread's counters (and to the trace, if one runs).
+ * * @param stage The stage the sample belongs to.
+ * @param startNs Now() when the stage began.
+ * @param endNs Now() when it ended.
+ * @param bytes Data moved by the sample, 0 if not applicable.
+ */
+void Profiler::Record(ProfileStage stage, uint64_t startNs, uint64_t endNs, uint64_t bytes) {
+    ThreadProfile& profile = t_profile.Get();
+    StageCounters& counters = profile.stages[static_cast<size_t>(stage)];
+    const uint64_t duration = endNs > startNs ? endNs - startNs : 0;
+
+    Bump(counters.count, 1);
+    Bump(counters.totalNs, duration);
+    Bump(counters.bytes, bytes);
+    if (duration > counters.maxNs.load(std::memory_order_relaxed)) counters.maxNs.store(duration, std::memory_order_relaxed);
+    Bump(counters.histogram[std::min<size_t>(std::bit_width(duration >> 10), kProfileBuckets - 1)], 1);
+
+    if (g_tracing.load(std::memory_order_relaxed)) AppendSpan(profile, stage, startNs, endNs, bytes);
+}
+
+const char* Profiler::GetStageName(ProfileStage stage) {
+    size_t index = static_cast<size_t>(stage);
+    return index < kProfileStageCount ? kStageNames[index] : "?";
+}
+
+/**
+ * @brief Adds up the counters of all live threads and of the threads that already exited.
+ */
+void Profiler::Snapshot(ProfileSnapshot& stats) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    stats = g_retired;
+    for (const ThreadProfile* profile : g_threads) {
+        for (size_t i = 0; i < kProfileStageCount; i++) AddCounters(stats[i], profile->stages[i]);
+    }
+}
+
+/**
+ * @brief Begins a new trace. Threads drop their old spans lazily, on their next sample.
+ */
+void Profiler::StartTrace(size_t maxEvents) {
+    std::vector<RetiredTrace> stale;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        stale.swap(g_retiredTraces);
+        g_traceOrigin = Now();
+        g_traceBudget = static_cast<int64_t>(maxEvents);
+        g_traceGeneration++;
+        g_tracing = true;
+    }
+    for (const RetiredTrace& trace : stale) FreeChunks(trace.firstChunk);
+}
+
+void Profiler::StopTrace() {
+    g_tracing = false;
+}
+
+bool Profiler::IsTracing() {
+    return g_tracing;
+}
+
+/**
+ * @brief Exports the spans of the current trace as complete ("X") events.
+ * * The spans are copied under the lock and written after it is released, so recording
+ * threads are never held up by the file I/O. Timestamps are microseconds since StartTrace.
+ */
+bool Profiler::WriteChromeTrace(const std::filesystem::path& path) {
+    std::vector<std::pair<DWORD, TraceEvent>> events;
+    uint64_t origin = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        origin = g_traceOrigin;
+        const uint64_t generation = g_traceGeneration.load();
+        auto collect = [&events](DWORD threadId, const TraceChunk* chunk) {
+            for (; chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+                const size_t used = chunk->used.load(std::memory_order_acquire);
+                for (size_t i = 0; i < used; i++) events.emplace_back(threadId, chunk->events[i]);
+            }
+        };
+        for (const ThreadProfile* profile : g_threads) {
+            if (profile->traceGeneration == generation) collect(profile->threadId, profile->firstChunk.load(std::memory_order_acquire));
+        }
+        for (const RetiredTrace& trace : g_retiredTraces) collect(trace.threadId, trace.firstChunk);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    char line[256];
+    for (size_t i = 0; i < events.size(); i++) {
+        const auto& [threadId, event] = events[i];
+        const uint64_t start = event.start > origin ? event.start - origin : 0;
+        snprintf(line, sizeof(line),
+                 "{\"name\":\"%s\",\"cat\":\"butler\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f,"
+                 "\"args\":{\"bytes\":%llu}}%s\n",
+                 GetStageName(event.stage), static_cast<unsigned long>(threadId), start / 1000.0,
+                 (event.end - event.start) / 1000.0, static_cast<unsigned long long>(event.bytes),
+                 i + 1 < events.size() ? "," : "");
+        out << line;
+    }
+    out << "]}\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <cstddef>
+#include <cstdint>
+
+// Timers compile to nothing when BUTLER_ENABLE_PROFILER is 0.
+#ifndef BUTLER_ENABLE_PROFILER
+#define BUTLER_ENABLE_PROFILER 1
+#endif
+
+inline constexpr bool kProfilerEnabled = (BUTLER_ENABLE_PROFILER != 0);
+
+/**
+ * @brief Instrumented stages of a transfer and of the UI.
+ */
+enum class ProfileStage : uint8_t {
+    Scan,       // Enumerating one folder of a job's source tree
+    Create,     // Opening/creating a destination file or folder
+    Read,       // One source read of the streaming engine (issue to completion)
+    Write,      // One destination write of the streaming engine
+    SystemCopy, // A whole CopyFileExW copy (its reads and writes cannot be told apart)
+    Verify,     // Reading a copy back and comparing its digest
+    Delete,     // Removing one source file or folder of a move
+    Refresh,    // FileBrowser::Refresh on the UI thread
+    Listing,    // A browser's background directory listing
+    Frame,      // CPU time of one UI frame (excluding the buffer swap)
+    Count
+};
+
+inline constexpr size_t kProfileStageCount = static_cast<size_t>(ProfileStage::Count);
+
+// Histogram bucket 0 holds durations below ~1 us; bucket i holds [2^(i-1), 2^i) * 1024 ns.
+inline constexpr size_t kProfileBuckets = 24;
+
+/**
+ * @brief Totals of one stage since startup, summed over all threads.
+ */
+struct ProfileStageStats {
+    uint64_t count = 0;
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+    uint64_t bytes = 0;
+    std::array<uint64_t, kProfileBuckets> histogram{};
+};
+
+using ProfileSnapshot = std::array<ProfileStageStats, kProfileStageCount>;
+
+/**
+ * @brief Process-wide timers and counters for the hot paths.
+ * * Every thread records into its own counters with plain relaxed stores, so a sample
+ * costs two clock reads and no locked instruction. Readers sum the threads' counters
+ * (Snapshot); a thread's totals are folded into a shared total when it exits.
+ * * Optionally every sample is also kept as a span (StartTrace) and can be written as a
+ * Chrome trace (chrome://tracing, Perfetto). Spans go into per-thread chunks that are
+ * published with release stores, so tracing does not lock either.
+ */
+class Profiler {
+public:
+    static uint64_t Now() {
+        if constexpr (!kProfilerEnabled) return 0;
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /**
+     * @brief Records a sample from startNs (a Now() value) until now.
+     */
+    static void RecordSince(ProfileStage stage, uint64_t startNs, uint64_t bytes = 0) {
+        if constexpr (kProfilerEnabled) Record(stage, startNs, Now(), bytes);
+    }
+    static void Record(ProfileStage stage, uint64_t startNs, uint64_t endNs, uint64_t bytes);
+
+    static const char* GetStageName(ProfileStage stage);
+
+    /**
+     * @brief Sums every thread's counters. Takes a lock; meant for a few calls per second.
+     */
+    static void Snapshot(ProfileSnapshot& stats);
+
+    /**
+     * @brief Starts keeping spans, discarding those of an earlier trace.
+     * @param maxEvents Spans kept at most; later samples are only counted.
+     */
+    static void StartTrace(size_t maxEvents = 4u * 1024 * 1024);
+    static void StopTrace();
+    static bool IsTracing();
+
+    /**
+     * @brief Writes the spans of the current (or last) trace in Chrome's JSON trace format.
+     * @return false if the file could not be written.
+     */
+    static bool WriteChromeTrace(const std::filesystem::path& path);
+};
+
+/**
+ * @brief Times the enclosing scope as one sample of a stage.
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileStage stage) : m_stage(stage), m_start(Profiler::Now()) {}
+    ~ProfileScope() { Profiler::RecordSince(m_stage, m_start, m_bytes); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    void AddBytes(uint64_t bytes) { m_bytes += bytes; }
+
+private:
+    ProfileStage m_stage;
+    uint64_t m_start;
+    uint64_t m_bytes = 0;
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include <windows.h>
+
+/**
+ * @brief Closes a Win32 handle when it goes out of scope.
+ * * Shared by the copy engines; treats both INVALID_HANDLE_VALUE and NULL as "no handle",
+ * since CreateFileW and CreateEventW report failure differently.
+ */
+struct ScopedHandle {
+    HANDLE h = INVALID_HANDLE_VALUE;
+
+    ScopedHandle() = default;
+    explicit ScopedHandle(HANDLE handle) : h(handle) {}
+    ~ScopedHandle() { if (Valid()) CloseHandle(h); }
+
+    ScopedHandle(const ScopedHandle&) = delete;
+    ScopedHandle& operator=(const ScopedHandle&) = delete;
+
+    bool Valid() const { return h != INVALID_HANDLE_VALUE && h != NULL; }
+};
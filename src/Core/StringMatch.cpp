@@ -0,0 +1,227 @@
+#include "StringMatch.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#include <immintrin.h>
+#define STRINGMATCH_X64 1
+#define STRINGMATCH_AVX2_TARGET
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <immintrin.h>
+#define STRINGMATCH_X64 1
+#define STRINGMATCH_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+/**
+ * @brief Lower-cases one ASCII letter; every other byte is returned unchanged.
+ */
+static inline char FoldByte(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+/**
+ * @brief Compares length bytes of text (folded) against already lower-cased bytes.
+ */
+static inline bool EqualFolded(const char* text, const char* lowered, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (FoldByte(text[i]) != lowered[i]) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Scalar search starting at a given haystack position.
+ */
+static bool ContainsFoldedFrom(std::string_view haystack, std::string_view needle, size_t start) {
+    const size_t n = needle.size();
+    const char first = needle[0];
+    for (size_t i = start; i + n <= haystack.size(); i++) {
+        if (FoldByte(haystack[i]) == first && EqualFolded(haystack.data() + i + 1, needle.data() + 1, n - 1)) return true;
+    }
+    return false;
+}
+
+#ifdef STRINGMATCH_X64
+
+// Short names are copied into a zero-padded stack buffer so they take a single vector step.
+static constexpr size_t kPaddedBytes = 128;
+
+/**
+ * @brief Index of the lowest set bit of a non-zero mask.
+ */
+static inline unsigned LowestBit(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return (unsigned)bit;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+/**
+ * @brief Lower-cases the ASCII letters of 16 bytes.
+ * * SSE2 has no unsigned compare, so bytes are shifted such that 'A'..'Z' land on the
+ * 26 smallest signed values and a signed compare selects them.
+ */
+static inline __m128i Fold16(__m128i bytes) {
+    const __m128i shifted = _mm_add_epi8(bytes, _mm_set1_epi8((char)(0x80 - 'A')));
+    const __m128i isUpper = _mm_cmplt_epi8(shifted, _mm_set1_epi8((char)(0x80 + 26)));
+    return _mm_or_si128(bytes, _mm_and_si128(isUpper, _mm_set1_epi8(0x20)));
+}
+
+/**
+ * @brief Tests the 16 start positions text[0..15] (restricted to positionMask).
+ * * Compares the first and last needle byte at every position at once; only positions
+ * where both match are verified byte by byte.
+ */
+static inline bool MatchBlock16(const char* text, std::string_view needle, unsigned positionMask) {
+    const size_t n = needle.size();
+    const __m128i blockFirst = Fold16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text)));
+    const __m128i blockLast = Fold16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + n - 1)));
+    unsigned mask = positionMask & (unsigned)_mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(blockFirst, _mm_set1_epi8(needle[0])),
+        _mm_cmpeq_epi8(blockLast, _mm_set1_epi8(needle[n - 1]))));
+    while (mask) {
+        unsigned bit = LowestBit(mask);
+        if (n <= 2 || EqualFolded(text + bit + 1, needle.data() + 1, n - 2)) return true;
+        mask &= mask - 1;
+    }
+    return false;
+}
+
+/**
+ * @brief SSE2 search over all start positions, 16 at a time.
+ * * The last partial step re-tests an overlapping full block. Haystacks with fewer than
+ * 16 start positions are copied into a padded buffer and tested in one step.
+ */
+static bool ContainsFoldedSse2(std::string_view haystack, std::string_view needle) {
+    const size_t positions = haystack.size() - needle.size() + 1;
+    const char* text = haystack.data();
+
+    if (positions < 16) {
+        if (haystack.size() + 16 > kPaddedBytes) return ContainsFoldedFrom(haystack, needle, 0);
+        alignas(16) char padded[kPaddedBytes] = {};
+        memcpy(padded, text, haystack.size());
+        return MatchBlock16(padded, needle, (1u << positions) - 1);
+    }
+
+    size_t i = 0;
+    for (; i + 16 <= positions; i += 16) {
+        if (MatchBlock16(text + i, needle, 0xFFFF)) return true;
+    }
+    return i < positions && MatchBlock16(text + positions - 16, needle, 0xFFFF);
+}
+
+/**
+ * @brief AVX2 variant of Fold16 for 32 bytes.
+ */
+STRINGMATCH_AVX2_TARGET static inline __m256i Fold32(__m256i bytes) {
+    const __m256i shifted = _mm256_add_epi8(bytes, _mm256_set1_epi8((char)(0x80 - 'A')));
+    const __m256i isUpper = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(0x80 + 26)), shifted);
+    return _mm256_or_si256(bytes, _mm256_and_si256(isUpper, _mm256_set1_epi8(0x20)));
+}
+
+/**
+ * @brief AVX2 search, same scheme as ContainsFoldedSse2 over 32 positions per step.
+ * * Only used when there are at least 32 start positions, so short names never touch
+ * the upper halves of the YMM registers (and pay no SSE/AVX transition cost).
+ */
+STRINGMATCH_AVX2_TARGET static bool ContainsFoldedAvx2(std::string_view haystack, std::string_view needle) {
+    const size_t n = needle.size();
+    const size_t positions = haystack.size() - n + 1;
+    const char* text = haystack.data();
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[n - 1]);
+
+    auto matchBlock = [&](const char* block) STRINGMATCH_AVX2_TARGET {
+        const __m256i blockFirst = Fold32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block)));
+        const __m256i blockLast = Fold32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + n - 1)));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last)));
+        while (mask) {
+            unsigned bit = LowestBit(mask);
+            if (n <= 2 || EqualFolded(block + bit + 1, needle.data() + 1, n - 2)) return true;
+            mask &= mask - 1;
+        }
+        return false;
+    };
+
+    size_t i = 0;
+    for (; i + 32 <= positions; i += 32) {
+        if (matchBlock(text + i)) return true;
+    }
+    return i < positions && matchBlock(text + positions - 32);
+}
+
+/**
+ * @brief Returns true if the CPU and the OS support AVX2.
+ */
+static bool DetectAvx2() {
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return false;
+    __cpuid(regs, 1);
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false; // OS must save YMM state
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static const bool g_hasAvx2 = DetectAvx2();
+
+#endif // STRINGMATCH_X64
+
+/**
+ * @brief Lower-cases the ASCII letters of a string.
+ * * @param text The text to convert.
+ * @return std::string The lower-cased copy.
+ */
+std::string StringMatch::ToLowerAscii(std::string_view text) {
+    std::string result(text);
+    for (char& c : result) c = FoldByte(c);
+    return result;
+}
+
+/**
+ * @brief Case-insensitive (ASCII) substring test using the best available kernel.
+ * * @param haystack The text to search.
+ * @param loweredNeedle The lower-cased text to look for.
+ * @return true if found (or if the needle is empty).
+ */
+bool StringMatch::ContainsFolded(std::string_view haystack, std::string_view loweredNeedle) {
+    if (loweredNeedle.empty()) return true;
+    if (loweredNeedle.size() > haystack.size()) return false;
+#ifdef STRINGMATCH_X64
+    if (g_hasAvx2 && haystack.size() - loweredNeedle.size() + 1 >= 32) return ContainsFoldedAvx2(haystack, loweredNeedle);
+    return ContainsFoldedSse2(haystack, loweredNeedle);
+#else
+    return ContainsFoldedFrom(haystack, loweredNeedle, 0);
+#endif
+}
+
+/**
+ * @brief Scalar version of ContainsFolded, used on non-x64 builds and as a reference.
+ */
+bool StringMatch::ContainsFoldedScalar(std::string_view haystack, std::string_view loweredNeedle) {
+    if (loweredNeedle.empty()) return true;
+    if (loweredNeedle.size() > haystack.size()) return false;
+    return ContainsFoldedFrom(haystack, loweredNeedle, 0);
+}
+
+/**
+ * @brief Reports which kernel ContainsFolded uses on this machine.
+ */
+const char* StringMatch::GetKernelName() {
+#ifdef STRINGMATCH_X64
+    return g_hasAvx2 ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/**
+ * @brief ASCII case-insensitive substring matching for file names.
+ * * Bytes outside A-Z/a-z (including every byte of a multi-byte UTF-8 sequence) are
+ * compared exactly, so UTF-8 names match correctly, just without Unicode case folding.
+ * On x64 the search runs 16 (SSE2) or 32 (AVX2, picked at runtime) haystack positions
+ * per step; elsewhere a scalar loop is used.
+ */
+class StringMatch {
+public:
+    /**
+     * @brief Returns a copy of text with ASCII letters lower-cased.
+     */
+    static std::string ToLowerAscii(std::string_view text);
+
+    /**
+     * @brief Returns true if haystack contains loweredNeedle, ignoring ASCII case.
+     * @param haystack Text to search, in any case.
+     * @param loweredNeedle Text to look for; must already be lower-cased (see ToLowerAscii).
+     * An empty needle always matches.
+     */
+    static bool ContainsFolded(std::string_view haystack, std::string_view loweredNeedle);
+
+    /**
+     * @brief Portable reference implementation of ContainsFolded.
+     */
+    static bool ContainsFoldedScalar(std::string_view haystack, std::string_view loweredNeedle);
+
+    /**
+     * @brief Name of the kernel ContainsFolded dispatches to ("avx2", "sse2" or "scalar").
+     */
+    static const char* GetKernelName();
+};
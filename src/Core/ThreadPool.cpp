@@ -0,0 +1,74 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+/**
+ * @brief Constructs the pool and starts its threads.
+ * * @param threadCount Number of worker threads; clamped to at least 1.
+ * @param maxQueued Backlog limit for Submit().
+ */
+ThreadPool::ThreadPool(unsigned int threadCount, size_t maxQueued)
+    : m_maxQueued(std::max<size_t>(maxQueued, 1)) {
+    threadCount = std::max(threadCount, 1u);
+    for (unsigned int i = 0; i < threadCount; i++) {
+        m_threads.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+/**
+ * @brief Drains the queue and joins all threads.
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_taskAvailable.notify_all();
+    for (auto& thread : m_threads) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+/**
+ * @brief Adds a task to the queue.
+ * * Applies back-pressure: the caller sleeps until the backlog drops below the limit.
+ * * @param task The callable to run on a pool thread.
+ */
+void ThreadPool::Submit(std::function<void()> task) {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_spaceAvailable.wait(lock, [this] { return m_tasks.size() < m_maxQueued; });
+        m_tasks.push_back(std::move(task));
+        m_inFlight++;
+    }
+    m_taskAvailable.notify_one();
+}
+
+/**
+ * @brief Waits until all submitted tasks (queued and running) have completed.
+ */
+void ThreadPool::Wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_allDone.wait(lock, [this] { return m_inFlight == 0; });
+}
+
+/**
+ * @brief Thread body: pops and runs tasks until the pool is stopped and the queue is empty.
+ */
+void ThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskAvailable.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+            if (m_tasks.empty()) return; // m_stop and nothing left to run
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        m_spaceAvailable.notify_one();
+
+        task();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_inFlight == 0) m_allDone.notify_all();
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/**
+ * @brief A fixed-size pool of threads consuming a bounded task queue.
+ * * Submit() blocks once the queue holds more than the configured backlog, so a
+ * producer enumerating millions of items never buffers them all in memory.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Spawns the pool.
+     * @param threadCount Number of threads (at least 1).
+     * @param maxQueued Maximum number of queued (not yet running) tasks before Submit() blocks.
+     */
+    explicit ThreadPool(unsigned int threadCount, size_t maxQueued = 256);
+
+    /**
+     * @brief Runs all remaining tasks, then joins the threads.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queues a task, blocking while the backlog is full. Tasks must not throw.
+     */
+    void Submit(std::function<void()> task);
+
+    /**
+     * @brief Blocks until every submitted task has finished.
+     */
+    void Wait();
+
+    unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_threads.size()); }
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> m_threads;
+    std::deque<std::function<void()>> m_tasks;
+    size_t m_maxQueued;
+    size_t m_inFlight = 0; // queued + running
+    bool m_stop = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_taskAvailable;
+    std::condition_variable m_spaceAvailable;
+    std::condition_variable m_allDone;
+};
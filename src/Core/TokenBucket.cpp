@@ -0,0 +1,59 @@
+#include "TokenBucket.h"
+#include <windows.h>
+#include <algorithm>
+
+// Longest single sleep in Acquire(); bounds how long a raised or lifted limit goes unnoticed.
+static constexpr uint64_t kMaxWaitMs = 100;
+// Smallest burst the bucket allows, so very low rates still pass whole small writes.
+static constexpr double kMinCapacity = 64.0 * 1024;
+
+/**
+ * @brief Sets the rate and sizes the bucket to a quarter second of it.
+ * * The bucket starts full so a newly limited transfer does not stall first.
+ * * @param bytesPerSecond New rate, 0 for unlimited.
+ */
+void TokenBucket::SetRate(uint64_t bytesPerSecond) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_rate = bytesPerSecond;
+    m_capacity = std::max(static_cast<double>(bytesPerSecond) / 4.0, kMinCapacity);
+    m_tokens = m_capacity;
+    m_lastTicks = GetTickCount64();
+}
+
+uint64_t TokenBucket::GetRate() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_rate;
+}
+
+/**
+ * @brief Adds the tokens earned since the last refill, capped at the bucket capacity.
+ * Must be called with m_mutex held.
+ */
+void TokenBucket::RefillLocked(uint64_t nowTicks) {
+    if (nowTicks <= m_lastTicks) return;
+    m_tokens = std::min(m_capacity, m_tokens + static_cast<double>(m_rate) * (nowTicks - m_lastTicks) / 1000.0);
+    m_lastTicks = nowTicks;
+}
+
+/**
+ * @brief Waits out any debt, then charges the bytes.
+ * * The lock is only held for the bookkeeping; waiting happens outside of it in short
+ * slices, re-reading the rate each time, so SetRate() applies to a caller mid-wait.
+ * * @param bytes Size of the block about to be (or just) transferred.
+ */
+void TokenBucket::Acquire(uint64_t bytes) {
+    for (;;) {
+        uint64_t waitMs;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_rate == 0) return;
+            RefillLocked(GetTickCount64());
+            if (m_tokens >= 0.0) {
+                m_tokens -= static_cast<double>(bytes);
+                return;
+            }
+            waitMs = static_cast<uint64_t>(-m_tokens * 1000.0 / static_cast<double>(m_rate)) + 1;
+        }
+        Sleep(static_cast<DWORD>(std::min(waitMs, kMaxWaitMs)));
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <mutex>
+#include <cstdint>
+
+/**
+ * @brief Thread-safe token bucket limiting a byte rate.
+ * * Tokens refill continuously at the configured rate up to a quarter second's worth.
+ * A caller may take a block as soon as the bucket is not in debt, even if the block is
+ * larger than the tokens left; the debt is then paid off by whoever comes next. Large
+ * blocks (multi-MB writes) are therefore never refused, while callers sharing the bucket
+ * still average out at the rate.
+ */
+class TokenBucket {
+public:
+    /**
+     * @param bytesPerSecond Initial rate; 0 means unlimited.
+     */
+    explicit TokenBucket(uint64_t bytesPerSecond = 0) { SetRate(bytesPerSecond); }
+
+    TokenBucket(const TokenBucket&) = delete;
+    TokenBucket& operator=(const TokenBucket&) = delete;
+
+    /**
+     * @brief Changes the rate. Takes effect for callers already waiting. 0 lifts the limit.
+     */
+    void SetRate(uint64_t bytesPerSecond);
+    uint64_t GetRate() const;
+
+    /**
+     * @brief Blocks until bytes may pass under the current rate, then charges them.
+     */
+    void Acquire(uint64_t bytes);
+
+private:
+    void RefillLocked(uint64_t nowTicks);
+
+    uint64_t m_rate = 0;     // Bytes per second, 0 = unlimited
+    double m_tokens = 0.0;   // Negative while in debt
+    double m_capacity = 0.0; // Largest burst
+    uint64_t m_lastTicks = 0;
+    mutable std::mutex m_mutex;
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include <windows.h>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Converts a wide string to UTF-8.
+ * * Unlike path::string(), which goes through the ANSI code page and throws for names it
+ * cannot represent (CJK, emoji), this never throws; unpaired surrogates become U+FFFD.
+ * Use it for log lines, error texts and anything ImGui displays.
+ */
+inline std::string ToUtf8(std::wstring_view wide) {
+    std::string utf8;
+    int bytes = wide.empty() ? 0 : WideCharToMultiByte(CP_UTF8, 0, wide.data(), (int)wide.size(), NULL, 0, NULL, NULL);
+    if (bytes > 0) {
+        utf8.resize(bytes);
+        WideCharToMultiByte(CP_UTF8, 0, wide.data(), (int)wide.size(), utf8.data(), bytes, NULL, NULL);
+    }
+    return utf8;
+}
+
+inline std::string ToUtf8(const std::wstring& wide) {
+    return ToUtf8(std::wstring_view(wide));
+}
+
+inline std::string ToUtf8(const std::filesystem::path& path) {
+    return ToUtf8(path.wstring());
+}
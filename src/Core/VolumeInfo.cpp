@@ -0,0 +1,79 @@
+#include "VolumeInfo.h"
+#include <windows.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+static std::mutex g_volumeMutex;
+static std::map<std::wstring, VolumeCapabilities> g_volumes; // Keyed by upper-cased mount point
+
+/**
+ * @brief Resolves the mount point a path lives on.
+ * * @param path Any absolute path, existing or not.
+ * @return std::wstring The mount point with a trailing backslash, or empty on failure.
+ */
+static std::wstring GetMountPoint(const std::filesystem::path& path) {
+    wchar_t root[MAX_PATH + 1];
+    if (!GetVolumePathNameW(path.c_str(), root, MAX_PATH + 1)) return L"";
+    return root;
+}
+
+/**
+ * @brief Looks up (and on first use queries) the capabilities of a volume.
+ * * The cache lock is not held during the query; two threads racing on a new volume
+ * both query it and the first result wins, which is harmless.
+ * * @param path A path on the volume.
+ * @return VolumeCapabilities Copy of the cached entry.
+ */
+VolumeCapabilities VolumeInfo::Query(const std::filesystem::path& path) {
+    VolumeCapabilities info;
+    info.root = GetMountPoint(path);
+    if (info.root.empty()) return info;
+
+    std::wstring key = info.root;
+    std::transform(key.begin(), key.end(), key.begin(), ::towupper);
+    {
+        std::lock_guard<std::mutex> lock(g_volumeMutex);
+        auto found = g_volumes.find(key);
+        if (found != g_volumes.end()) return found->second;
+    }
+
+    wchar_t fsName[MAX_PATH + 1] = {};
+    DWORD serial = 0, maxComponent = 0, flags = 0;
+    if (GetVolumeInformationW(info.root.c_str(), NULL, 0, &serial, &maxComponent, &flags, fsName, MAX_PATH + 1)) {
+        info.valid = true;
+        info.fileSystem = fsName;
+        info.serialNumber = serial;
+        info.blockCloning = (flags & FILE_SUPPORTS_BLOCK_REFCOUNTING) != 0;
+        info.hardLinks = (flags & FILE_SUPPORTS_HARD_LINKS) != 0;
+
+        DWORD sectorsPerCluster = 0, bytesPerSector = 0, freeClusters = 0, totalClusters = 0;
+        if (GetDiskFreeSpaceW(info.root.c_str(), &sectorsPerCluster, &bytesPerSector, &freeClusters, &totalClusters)) {
+            info.clusterSize = sectorsPerCluster * bytesPerSector;
+        }
+        // Cloning needs the cluster size to align its ranges
+        if (info.clusterSize == 0) info.blockCloning = false;
+    }
+    if (!info.valid) return info; // Not cached: the volume may just be offline
+
+    std::lock_guard<std::mutex> lock(g_volumeMutex);
+    return g_volumes.emplace(std::move(key), info).first->second;
+}
+
+/**
+ * @brief Compares the volumes of two paths by serial number.
+ * * Local volumes mounted at several places share a serial and can rename between their
+ * mount points. Network shares of one server volume share it too but cannot, so those
+ * must also have the same mount point.
+ * * @return true only if both volumes could be queried and are the same.
+ */
+bool VolumeInfo::SameVolume(const std::filesystem::path& a, const std::filesystem::path& b) {
+    return SameVolume(Query(a), Query(b));
+}
+
+bool VolumeInfo::SameVolume(const VolumeCapabilities& first, const VolumeCapabilities& second) {
+    if (!first.valid || !second.valid) return false;
+    if (first.serialNumber != second.serialNumber || first.fileSystem != second.fileSystem) return false;
+    const bool remote = first.root.rfind(L"\\\\", 0) == 0 || second.root.rfind(L"\\\\", 0) == 0;
+    return !remote || _wcsicmp(first.root.c_str(), second.root.c_str()) == 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <cstdint>
+
+/**
+ * @brief What a volume can do, as far as the copy fast paths are concerned.
+ */
+struct VolumeCapabilities {
+    std::wstring root;           // Volume mount point, e.g. "C:\" or "\\server\share\"
+    std::wstring fileSystem;     // "NTFS", "ReFS", ... (empty if the query failed)
+    uint32_t serialNumber = 0;   // Identifies the volume; equal serials mean rename-able
+    uint32_t clusterSize = 0;    // Bytes per cluster (clone ranges must be multiples of it)
+    bool valid = false;          // GetVolumeInformationW succeeded
+    bool blockCloning = false;   // FILE_SUPPORTS_BLOCK_REFCOUNTING (ReFS, Dev Drive)
+    bool hardLinks = false;      // FILE_SUPPORTS_HARD_LINKS
+};
+
+/**
+ * @brief Process-wide cache of volume capabilities.
+ * * Each volume is queried once (GetVolumeInformationW + GetDiskFreeSpaceW); later lookups
+ * only resolve the path to its mount point. Paths that do not exist yet resolve through
+ * their existing ancestors, so a destination can be checked before it is created.
+ */
+class VolumeInfo {
+public:
+    /**
+     * @brief Returns the capabilities of the volume holding path. Thread-safe.
+     * On failure the result has valid == false and no capabilities.
+     */
+    static VolumeCapabilities Query(const std::filesystem::path& path);
+
+    /**
+     * @brief True if both paths are known to live on the same volume (a rename between
+     * them cannot fail with ERROR_NOT_SAME_DEVICE). Mount points and UNC paths are handled,
+     * unlike a drive-letter comparison.
+     */
+    static bool SameVolume(const std::filesystem::path& a, const std::filesystem::path& b);
+
+    /**
+     * @brief Same check on capabilities already queried, for callers comparing many
+     * paths against one volume.
+     */
+    static bool SameVolume(const VolumeCapabilities& a, const VolumeCapabilities& b);
+};
@@ -0,0 +1,84 @@
+#include "CloneCopy.h"
+#include "../Core/ScopedHandle.h"
+#include <windows.h>
+#include <winioctl.h>
+#include <algorithm>
+
+// FSCTL_DUPLICATE_EXTENTS_TO_FILE takes less than 4 GB per call; clone in 1 GB regions.
+static constexpr uint64_t kCloneRegionSize = 1024ull * 1024 * 1024;
+
+/**
+ * @brief Clones a file region by region.
+ * * The destination is sized to the source first (clones must land inside the file) and
+ * made sparse if the source is, as the file system requires. Regions are cluster aligned;
+ * the last one is rounded up to a whole cluster, which the file system allows when it
+ * ends at end of file. Timestamps and attributes are carried over at the end.
+ * * @param src Source file.
+ * @param dst Destination file (overwritten).
+ * @param clusterSize Alignment of the clone regions.
+ * @param onProgress Called after each region; returning false cancels.
+ * @param failIfExists Only create a new dst, never overwrite one.
+ * @return true on success, false with GetLastError() set otherwise.
+ */
+bool BlockCloneEngine::Copy(const std::filesystem::path& src, const std::filesystem::path& dst, uint32_t clusterSize,
+                            const ProgressCallback& onProgress, bool failIfExists) {
+    if (clusterSize == 0) {
+        SetLastError(ERROR_NOT_SUPPORTED);
+        return false;
+    }
+
+    ScopedHandle source{ CreateFileW(src.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL) };
+    if (!source.Valid()) return false;
+
+    LARGE_INTEGER size;
+    FILE_BASIC_INFO basicInfo;
+    if (!GetFileSizeEx(source.h, &size) ||
+        !GetFileInformationByHandleEx(source.h, FileBasicInfo, &basicInfo, sizeof(basicInfo))) {
+        return false;
+    }
+    const uint64_t totalBytes = static_cast<uint64_t>(size.QuadPart);
+
+    DWORD error = ERROR_SUCCESS;
+    {
+        ScopedHandle dest{ CreateFileW(dst.c_str(), GENERIC_READ | GENERIC_WRITE | FILE_WRITE_ATTRIBUTES, 0, NULL,
+                                      failIfExists ? CREATE_NEW : CREATE_ALWAYS, 0, NULL) };
+        if (!dest.Valid()) return false;
+
+        DWORD bytes = 0;
+        FILE_END_OF_FILE_INFO eof{};
+        eof.EndOfFile = size;
+        if ((basicInfo.FileAttributes & FILE_ATTRIBUTE_SPARSE_FILE) &&
+            !DeviceIoControl(dest.h, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &bytes, NULL)) {
+            error = GetLastError();
+        } else if (!SetFileInformationByHandle(dest.h, FileEndOfFileInfo, &eof, sizeof(eof))) {
+            error = GetLastError();
+        }
+
+        const uint64_t alignedEnd = ((totalBytes + clusterSize - 1) / clusterSize) * clusterSize;
+        for (uint64_t offset = 0; error == ERROR_SUCCESS && offset < alignedEnd; offset += kCloneRegionSize) {
+            DUPLICATE_EXTENTS_DATA extents{};
+            extents.FileHandle = source.h;
+            extents.SourceFileOffset.QuadPart = static_cast<LONGLONG>(offset);
+            extents.TargetFileOffset.QuadPart = static_cast<LONGLONG>(offset);
+            extents.ByteCount.QuadPart = static_cast<LONGLONG>(std::min(kCloneRegionSize, alignedEnd - offset));
+            if (!DeviceIoControl(dest.h, FSCTL_DUPLICATE_EXTENTS_TO_FILE, &extents, sizeof(extents), NULL, 0, &bytes, NULL)) {
+                error = GetLastError();
+                break;
+            }
+            if (onProgress && !onProgress(std::min(offset + kCloneRegionSize, totalBytes), totalBytes)) {
+                error = ERROR_REQUEST_ABORTED;
+            }
+        }
+
+        if (error == ERROR_SUCCESS && !SetFileInformationByHandle(dest.h, FileBasicInfo, &basicInfo, sizeof(basicInfo))) {
+            error = GetLastError();
+        }
+    }
+
+    if (error != ERROR_SUCCESS) {
+        DeleteFileW(dst.c_str());
+        SetLastError(error);
+        return false;
+    }
+    return true;
+}
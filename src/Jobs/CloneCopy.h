@@ -0,0 +1,35 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <cstdint>
+
+/**
+ * @brief Copies a file by cloning its extents (FSCTL_DUPLICATE_EXTENTS_TO_FILE).
+ * * On volumes with block reference counting (ReFS, Dev Drive) the copy shares the
+ * source's clusters copy-on-write: no data is read or written, so a multi-GB file is
+ * duplicated in milliseconds and takes no extra space until either side is modified.
+ * Source and destination must be on the same volume.
+ */
+class BlockCloneEngine {
+public:
+    /**
+     * @brief Invoked after every cloned region with (bytesDone, totalBytes).
+     * Returning false cancels the copy.
+     */
+    using ProgressCallback = std::function<bool(uint64_t, uint64_t)>;
+
+    /**
+     * @brief Clones src into dst, overwriting dst if it exists.
+     * @param src Source file.
+     * @param dst Destination file on the same volume.
+     * @param clusterSize Cluster size of the volume (see VolumeInfo).
+     * @param onProgress Optional progress/cancel callback.
+     * @param failIfExists Create dst with CREATE_NEW; an existing dst fails with ERROR_FILE_EXISTS
+     * and is left alone.
+     * @return true on success. On failure the destination is deleted and GetLastError()
+     * holds the Win32 error (ERROR_NOT_SUPPORTED etc. when the volume cannot clone).
+     */
+    static bool Copy(const std::filesystem::path& src, const std::filesystem::path& dst, uint32_t clusterSize,
+                     const ProgressCallback& onProgress = nullptr, bool failIfExists = false);
+};
@@ -0,0 +1,240 @@
+#include "DeltaCopy.h"
+#include "../Core/Hash.h"
+#include "../Core/BufferPool.h"
+#include "../Core/ScopedHandle.h"
+#include <windows.h>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cwctype>
+
+static constexpr uint32_t kSignatureMagic = 0x47495342; // "BSIG"
+static constexpr uint32_t kSignatureVersion = 1;
+static constexpr size_t kMinDeltaBlockSize = 64 * 1024;
+static constexpr size_t kMaxDeltaBlockSize = 64 * 1024 * 1024;
+
+/**
+ * @brief Header of a signature file; followed by blockCount 64-bit block hashes.
+ * * fileSize and lastWriteTime describe the destination as it was left by the transfer
+ * that wrote the signature.
+ */
+struct SignatureHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t blockSize;
+    uint64_t fileSize;
+    uint64_t lastWriteTime;
+    uint64_t blockCount;
+};
+
+/**
+ * @brief Returns the signature file that belongs to a destination path.
+ * * Named after the hash of the upper-cased absolute path, so "D:\VM\disk.vhdx" and
+ * "d:\vm\DISK.vhdx" share one signature.
+ */
+static std::filesystem::path GetSignaturePath(const DeltaCopyOptions& options, const std::filesystem::path& dst) {
+    std::error_code ec;
+    std::wstring key = std::filesystem::absolute(dst, ec).wstring();
+    if (ec) key = dst.wstring();
+    std::transform(key.begin(), key.end(), key.begin(), ::towupper);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.sig",
+             (unsigned long long)Xxh64::Hash(key.data(), key.size() * sizeof(wchar_t)));
+    return options.signatureDir / name;
+}
+
+/**
+ * @brief Loads a signature if it still describes the destination.
+ * * @param blockSize, fileSize, lastWriteTime The destination's current state; all must match.
+ * @param hashes Receives the block hashes.
+ * @return false if there is no usable signature.
+ */
+static bool LoadSignature(const std::filesystem::path& path, uint64_t blockSize, uint64_t fileSize,
+                          uint64_t lastWriteTime, std::vector<uint64_t>& hashes) {
+    std::ifstream in(path, std::ios::binary);
+    SignatureHeader header{};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (header.magic != kSignatureMagic || header.version != kSignatureVersion || header.blockSize != blockSize ||
+        header.fileSize != fileSize || header.lastWriteTime != lastWriteTime ||
+        header.blockCount != (fileSize + blockSize - 1) / blockSize) {
+        return false;
+    }
+    hashes.resize(static_cast<size_t>(header.blockCount));
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(hashes.data()), hashes.size() * sizeof(uint64_t)));
+}
+
+/**
+ * @brief Writes a signature (best effort; a missing signature only costs a re-read).
+ */
+static void SaveSignature(const std::filesystem::path& path, uint64_t blockSize, uint64_t fileSize,
+                          uint64_t lastWriteTime, const std::vector<uint64_t>& hashes) {
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    SignatureHeader header{ kSignatureMagic, kSignatureVersion, blockSize, fileSize, lastWriteTime, hashes.size() };
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(hashes.data()), hashes.size() * sizeof(uint64_t));
+    out.close();
+    if (!out) std::filesystem::remove(path, ec);
+}
+
+/**
+ * @brief Points an OVERLAPPED at a file offset for a positioned synchronous transfer.
+ */
+static OVERLAPPED AtOffset(uint64_t offset) {
+    OVERLAPPED ov{};
+    ov.Offset = static_cast<DWORD>(offset);
+    ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    return ov;
+}
+
+/**
+ * @brief Reads exactly length bytes (sequentially, or at offset if one is given).
+ */
+static bool ReadExact(HANDLE file, BYTE* buffer, DWORD length, const uint64_t* offset = nullptr) {
+    DWORD done = 0;
+    while (done < length) {
+        DWORD bytes = 0;
+        OVERLAPPED ov = AtOffset(offset ? *offset + done : 0);
+        if (!ReadFile(file, buffer + done, length - done, &bytes, offset ? &ov : NULL)) return false;
+        if (bytes == 0) { SetLastError(ERROR_HANDLE_EOF); return false; }
+        done += bytes;
+    }
+    return true;
+}
+
+/**
+ * @brief Writes length bytes at the given offset.
+ */
+static bool WriteAt(HANDLE file, const BYTE* buffer, DWORD length, uint64_t offset) {
+    DWORD done = 0;
+    while (done < length) {
+        DWORD bytes = 0;
+        OVERLAPPED ov = AtOffset(offset + done);
+        if (!WriteFile(file, buffer + done, length - done, &bytes, &ov)) return false;
+        done += bytes;
+    }
+    return true;
+}
+
+/**
+ * @brief Brings the destination up to date block by block.
+ * * A block is considered unchanged if it lies entirely inside the old destination and
+ * either its hash equals the cached signature entry or its bytes equal the destination's.
+ * The old signature is deleted before the first write so an interrupted transfer never
+ * leaves a stale one behind.
+ * * @param src Source file.
+ * @param dst Destination file (must exist).
+ * @param options Block size and signature cache.
+ * @param onProgress Called after each block; returning false cancels.
+ * @param stats Receives the counters if not null.
+ * @return true on success, false with GetLastError() set otherwise.
+ */
+bool DeltaCopyEngine::Copy(const std::filesystem::path& src, const std::filesystem::path& dst,
+                           const DeltaCopyOptions& options, const ProgressCallback& onProgress,
+                           DeltaCopyStats* stats) {
+    ScopedHandle source{ CreateFileW(src.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, NULL) };
+    if (!source.Valid()) return false;
+
+    LARGE_INTEGER size;
+    FILE_BASIC_INFO basicInfo;
+    if (!GetFileSizeEx(source.h, &size) ||
+        !GetFileInformationByHandleEx(source.h, FileBasicInfo, &basicInfo, sizeof(basicInfo))) {
+        return false;
+    }
+    const uint64_t totalBytes = static_cast<uint64_t>(size.QuadPart);
+    const uint64_t blockSize = std::clamp(options.blockSize, kMinDeltaBlockSize, kMaxDeltaBlockSize);
+    const std::filesystem::path signaturePath = options.signatureDir.empty() ? std::filesystem::path() : GetSignaturePath(options, dst);
+
+    DeltaCopyStats result;
+    std::vector<uint64_t> hashes;
+    hashes.reserve(static_cast<size_t>((totalBytes + blockSize - 1) / blockSize));
+    DWORD error = ERROR_SUCCESS;
+    {
+        ScopedHandle dest{ CreateFileW(dst.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, NULL) };
+        if (!dest.Valid()) return false;
+
+        LARGE_INTEGER destSize;
+        FILE_BASIC_INFO destInfo;
+        if (!GetFileSizeEx(dest.h, &destSize) ||
+            !GetFileInformationByHandleEx(dest.h, FileBasicInfo, &destInfo, sizeof(destInfo))) {
+            return false;
+        }
+        const uint64_t destLength = static_cast<uint64_t>(destSize.QuadPart);
+
+        std::vector<uint64_t> known;
+        if (!signaturePath.empty()) {
+            result.usedSignature = !options.verifyTarget &&
+                LoadSignature(signaturePath, blockSize, destLength, static_cast<uint64_t>(destInfo.LastWriteTime.QuadPart), known);
+            DeleteFileW(signaturePath.c_str());
+        }
+
+        // One lease holds both blocks (pool callers keep a single lease at a time)
+        BufferLease lease = BufferPool::Shared().Acquire(static_cast<size_t>(blockSize) * (result.usedSignature ? 1 : 2));
+        if (!lease) return false;
+        BYTE* sourceBlock = lease.Data();
+        BYTE* targetBlock = sourceBlock + blockSize;
+
+        for (uint64_t offset = 0; offset < totalBytes; offset += blockSize) {
+            const DWORD length = static_cast<DWORD>(std::min(blockSize, totalBytes - offset));
+            if (!ReadExact(source.h, sourceBlock, length)) { error = GetLastError(); break; }
+            const uint64_t blockHash = Xxh64::Hash(sourceBlock, length);
+            const size_t index = hashes.size();
+            hashes.push_back(blockHash);
+            result.blocksTotal++;
+
+            bool unchanged = false;
+            if (offset + length <= destLength) {
+                if (result.usedSignature) {
+                    unchanged = (known[index] == blockHash);
+                } else {
+                    if (!ReadExact(dest.h, targetBlock, length, &offset)) { error = GetLastError(); break; }
+                    unchanged = (memcmp(sourceBlock, targetBlock, length) == 0);
+                }
+            }
+
+            if (!unchanged) {
+                if (!WriteAt(dest.h, sourceBlock, length, offset)) { error = GetLastError(); break; }
+                result.blocksWritten++;
+                result.bytesWritten += length;
+            }
+
+            if (onProgress && !onProgress(offset + length, totalBytes)) { error = ERROR_REQUEST_ABORTED; break; }
+        }
+
+        if (error == ERROR_SUCCESS) {
+            FILE_END_OF_FILE_INFO eof{};
+            eof.EndOfFile.QuadPart = static_cast<LONGLONG>(totalBytes);
+            if ((destLength != totalBytes && !SetFileInformationByHandle(dest.h, FileEndOfFileInfo, &eof, sizeof(eof))) ||
+                !SetFileInformationByHandle(dest.h, FileBasicInfo, &basicInfo, sizeof(basicInfo))) {
+                error = GetLastError();
+            }
+        }
+    }
+
+    if (error == ERROR_SUCCESS && blockSize == ChunkedDigest::kChunkSize) {
+        // The block hashes are exactly the digest's chunk hashes, so the digest comes for free.
+        result.hasSourceDigest = true;
+        result.sourceDigest = ChunkedDigest::Combine(hashes);
+    }
+    if (stats) *stats = result;
+    if (error != ERROR_SUCCESS) {
+        SetLastError(error);
+        return false;
+    }
+
+    // Record the destination as it is now, after the handle is closed and its times are final.
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!signaturePath.empty() && GetFileAttributesExW(dst.c_str(), GetFileExInfoStandard, &data)) {
+        const uint64_t finalSize = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        const uint64_t finalTime = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+        if (finalSize == totalBytes) SaveSignature(signaturePath, blockSize, finalSize, finalTime, hashes);
+    }
+    return true;
+}
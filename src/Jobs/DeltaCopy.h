@@ -0,0 +1,67 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <cstdint>
+
+/**
+ * @brief Tuning knobs of the block delta engine.
+ */
+struct DeltaCopyOptions {
+    size_t blockSize = 1024 * 1024; // Bytes per compared block
+    // Where block signatures of previous transfers are kept. Empty disables the cache,
+    // in which case every delta reads the destination back.
+    std::filesystem::path signatureDir = "cache/signatures";
+    // Ignore cached signatures and always compare against the destination's real content.
+    bool verifyTarget = false;
+};
+
+/**
+ * @brief What a delta transfer did.
+ */
+struct DeltaCopyStats {
+    uint64_t blocksTotal = 0;
+    uint64_t blocksWritten = 0;
+    uint64_t bytesWritten = 0;
+    bool usedSignature = false; // Destination content was taken from the signature cache
+    // ChunkedDigest of the source, available when the block size equals the digest chunk size
+    bool hasSourceDigest = false;
+    uint64_t sourceDigest = 0;
+};
+
+/**
+ * @brief Updates an existing file in place by rewriting only the blocks that differ.
+ * * The source is read in fixed-size blocks and every block is hashed (XXH64). Each block
+ * is compared with the matching block of the destination. Only blocks that differ (and any
+ * data past the old end) are written, then the destination is truncated or extended to the
+ * source length and given the source's timestamps and attributes.
+ * * The hashes are saved as a signature next to the destination's size and timestamp.
+ * If the destination still has that size and timestamp at the next transfer, the signature
+ * stands in for its content and the destination is not read at all. For a network target
+ * only the changed blocks then cross the wire.
+ * * Fixed blocks match in-place edits (VM disks, PST files, databases). Inserting data
+ * shifts every later block, so such files fall back to a full rewrite in effect.
+ */
+class DeltaCopyEngine {
+public:
+    /**
+     * @brief Invoked after every processed block with (sourceBytesDone, totalBytes).
+     * Returning false cancels the transfer. May block (e.g. while the queue is paused).
+     */
+    using ProgressCallback = std::function<bool(uint64_t, uint64_t)>;
+
+    /**
+     * @brief Brings dst up to date with src.
+     * @param src Source file.
+     * @param dst Existing destination file, updated in place.
+     * @param options Block size and signature cache location.
+     * @param onProgress Optional progress/cancel callback.
+     * @param stats Optional; receives block and byte counts.
+     * @return true on success. On failure dst may hold a mix of old and new blocks (its
+     * timestamp then differs from the source, so the next sync repairs it) and
+     * GetLastError() holds the Win32 error.
+     */
+    static bool Copy(const std::filesystem::path& src, const std::filesystem::path& dst,
+                     const DeltaCopyOptions& options, const ProgressCallback& onProgress = nullptr,
+                     DeltaCopyStats* stats = nullptr);
+};
@@ -0,0 +1,131 @@
+#include "DestinationNames.h"
+#include <windows.h>
+#include <algorithm>
+#include <cwctype>
+
+// A folder listing is trusted for this long; later lookups list the folder again.
+static constexpr uint64_t kListingTtlMs = 10000;
+
+// Unreserved listings beyond this count are dropped once they are stale.
+static constexpr size_t kMaxListings = 64;
+
+/**
+ * @brief File names compare case-insensitively on Windows, so keys are upper-cased.
+ */
+static std::wstring GetNameKey(std::wstring name) {
+    std::transform(name.begin(), name.end(), name.begin(), ::towupper);
+    return name;
+}
+
+/**
+ * @brief Reads the names in a folder. A folder that does not exist yet has none.
+ * * @return false if the folder could not be listed (names is then incomplete).
+ */
+static bool ListFolder(const std::filesystem::path& folder, std::unordered_set<std::wstring>& names) {
+    WIN32_FIND_DATAW data;
+    HANDLE find = FindFirstFileExW((folder / L"*").c_str(), FindExInfoBasic, &data, FindExSearchNameMatch, NULL,
+                                   FIND_FIRST_EX_LARGE_FETCH);
+    if (find == INVALID_HANDLE_VALUE) {
+        DWORD error = GetLastError();
+        return error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND;
+    }
+    do {
+        const wchar_t* name = data.cFileName;
+        if (name[0] == L'.' && (name[1] == L'\0' || (name[1] == L'.' && name[2] == L'\0'))) continue;
+        names.insert(GetNameKey(name));
+    } while (FindNextFileW(find, &data));
+    FindClose(find);
+    return true;
+}
+
+/**
+ * @brief Returns the resolver shared by all transfer managers.
+ */
+DestinationNames& DestinationNames::Shared() {
+    static DestinationNames names;
+    return names;
+}
+
+/**
+ * @brief Returns the cached listing of a folder, listing it first if needed.
+ * * The folder is enumerated with the lock released so a slow share does not hold up
+ * jobs resolving names elsewhere. If another thread refreshed the same listing in the
+ * meantime, its result is kept. Reservations survive a refresh.
+ * * @param folder The destination folder.
+ * @param lock Holds m_mutex on entry and on return.
+ */
+DestinationNames::Listing& DestinationNames::GetListing(const std::filesystem::path& folder,
+                                                        std::unique_lock<std::mutex>& lock) {
+    const std::wstring key = GetNameKey(folder.wstring());
+    const uint64_t started = GetTickCount64();
+    auto found = m_listings.find(key);
+    if (found != m_listings.end() && found->second.loadedAt + kListingTtlMs > started) return found->second;
+
+    lock.unlock();
+    std::unordered_set<std::wstring> names;
+    const bool listed = ListFolder(folder, names);
+    lock.lock();
+
+    if (m_listings.size() >= kMaxListings) {
+        for (auto it = m_listings.begin(); it != m_listings.end();) {
+            const bool idle = it->second.reserved.empty() && it->second.loadedAt + kListingTtlMs <= started;
+            it = (idle && it->first != key) ? m_listings.erase(it) : std::next(it);
+        }
+    }
+
+    Listing& listing = m_listings[key];
+    if (listing.loadedAt < started) {
+        listing.names = std::move(names);
+        listing.nextCounter.clear();
+        // An incomplete listing is used once and then retried; atomic creation covers the gap.
+        listing.loadedAt = listed ? GetTickCount64() : 0;
+    }
+    return listing;
+}
+
+/**
+ * @brief Reserves target or its first free numbered variant ("File (1).txt", ...).
+ * * Counting resumes where the previous reservation of the same base name stopped, so
+ * a long run of taken variants is walked once per listing, not once per file.
+ * * @param target The desired destination path.
+ * @return A path that is neither listed nor reserved.
+ */
+std::filesystem::path DestinationNames::Reserve(const std::filesystem::path& target) {
+    const std::filesystem::path folder = target.parent_path();
+    const std::wstring baseKey = GetNameKey(target.filename().wstring());
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Listing& listing = GetListing(folder, lock);
+    auto isFree = [&listing](const std::wstring& nameKey) {
+        return !listing.names.contains(nameKey) && !listing.reserved.contains(nameKey);
+    };
+    if (isFree(baseKey)) {
+        listing.reserved.insert(baseKey);
+        return target;
+    }
+
+    const std::wstring stem = target.stem().wstring();
+    const std::wstring ext = target.extension().wstring();
+    uint32_t& counter = listing.nextCounter[baseKey];
+    for (counter = std::max(counter, 1u);; counter++) {
+        std::wstring name = stem + L" (" + std::to_wstring(counter) + L")" + ext;
+        std::wstring nameKey = GetNameKey(name);
+        if (isFree(nameKey)) {
+            counter++;
+            listing.reserved.insert(std::move(nameKey));
+            return folder / name;
+        }
+    }
+}
+
+/**
+ * @brief Drops a reservation; a name that now exists stays marked as taken.
+ */
+void DestinationNames::Release(const std::filesystem::path& reserved, bool exists) {
+    const std::wstring nameKey = GetNameKey(reserved.filename().wstring());
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_listings.find(GetNameKey(reserved.parent_path().wstring()));
+    if (found == m_listings.end()) return;
+    found->second.reserved.erase(nameKey);
+    if (exists) found->second.names.insert(nameKey);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <cstdint>
+
+/**
+ * @brief Picks collision-free destination names ("File (1).txt", ...) for queued jobs.
+ * * Each destination folder is listed once (one FindFirstFileExW pass) and names are then
+ * resolved against that cached listing in memory, so a folder that already holds
+ * "report (1)" to "report (500)" costs no extra lookups per file. Names handed out are
+ * reserved until the job is done with them, so jobs running at the same time never pick
+ * the same name.
+ * * The listing can go stale (other programs also write there). Callers therefore create
+ * the reserved target atomically (CREATE_NEW, COPY_FILE_FAIL_IF_EXISTS, a non-replacing
+ * rename) and, if that reports the name as taken, release it as existing and reserve again.
+ * Listings are reloaded once they are older than a few seconds.
+ */
+class DestinationNames {
+public:
+    static DestinationNames& Shared();
+
+    /**
+     * @brief Returns target, or the first numbered variant of it, that is neither in the
+     * folder's listing nor reserved, and reserves it. Thread-safe.
+     */
+    std::filesystem::path Reserve(const std::filesystem::path& target);
+
+    /**
+     * @brief Ends a reservation made by Reserve().
+     * @param reserved The path Reserve() returned.
+     * @param exists Whether the name is now taken on disk (created, or found to be in use).
+     */
+    void Release(const std::filesystem::path& reserved, bool exists);
+
+private:
+    struct Listing {
+        std::unordered_set<std::wstring> names;    // Upper-cased names present on disk
+        std::unordered_set<std::wstring> reserved; // Upper-cased names held by running jobs
+        std::unordered_map<std::wstring, uint32_t> nextCounter; // Per base name: first counter worth trying
+        uint64_t loadedAt = 0;                     // GetTickCount64() of the listing
+    };
+
+    Listing& GetListing(const std::filesystem::path& folder, std::unique_lock<std::mutex>& lock);
+
+    std::mutex m_mutex;
+    std::unordered_map<std::wstring, Listing> m_listings; // By upper-cased folder path
+};
@@ -0,0 +1,122 @@
+#include "DirectoryScan.h"
+#include "../Core/Profiler.h"
+#include "../Core/Utf8.h"
+#include <windows.h>
+#include <vector>
+#include <algorithm>
+
+// Entries are published to consumers in batches to keep lock traffic low.
+static constexpr size_t kPublishBatch = 256;
+
+/**
+ * @brief Converts a FILETIME to a single 64-bit tick count.
+ */
+static uint64_t FileTimeToTicks(const FILETIME& ft) {
+    return (static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+}
+
+/**
+ * @brief Constructs the scanner and launches the enumeration thread.
+ * * @param root The directory to enumerate.
+ */
+DirectoryScanner::DirectoryScanner(const std::filesystem::path& root) : m_root(root) {
+    m_thread = std::thread(&DirectoryScanner::ScanLoop, this);
+}
+
+/**
+ * @brief Cancels an unfinished scan and waits for the thread to exit.
+ */
+DirectoryScanner::~DirectoryScanner() {
+    m_cancel = true;
+    if (m_thread.joinable()) m_thread.join();
+}
+
+/**
+ * @brief Pops the next entry of the manifest.
+ * * The entry is removed from the queue, so a huge tree never stays resident.
+ * * @param entry Receives the entry.
+ * @return true if an entry was returned, false when the scan is over and drained.
+ */
+bool DirectoryScanner::Next(ManifestEntry& entry) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_entryAvailable.wait(lock, [this] { return !m_entries.empty() || m_complete; });
+    if (m_entries.empty()) return false;
+    entry = std::move(m_entries.front());
+    m_entries.pop_front();
+    return true;
+}
+
+/**
+ * @brief Thread body: iterative depth-first enumeration of the tree.
+ * * Each directory is listed exactly once; sizes are taken from the find data instead of
+ * stat-ing every file. Reparse-point directories (junctions, symlinks) are recorded but
+ * not descended into. The first directory that cannot be listed aborts the scan.
+ */
+void DirectoryScanner::ScanLoop() {
+    std::vector<std::filesystem::path> pending{ std::filesystem::path() };
+    std::vector<ManifestEntry> batch;
+    batch.reserve(kPublishBatch);
+
+    auto publish = [&]() {
+        if (batch.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& e : batch) m_entries.push_back(std::move(e));
+        }
+        batch.clear();
+        m_entryAvailable.notify_all();
+    };
+
+    while (!pending.empty() && !m_cancel) {
+        ProfileScope scanScope(ProfileStage::Scan);
+        std::filesystem::path relativeDir = std::move(pending.back());
+        pending.pop_back();
+
+        std::filesystem::path pattern = (m_root / relativeDir) / L"*";
+        WIN32_FIND_DATAW data;
+        HANDLE find = FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &data, FindExSearchNameMatch, NULL,
+                                       FIND_FIRST_EX_LARGE_FETCH);
+        if (find == INVALID_HANDLE_VALUE) {
+            DWORD error = GetLastError();
+            if (error == ERROR_FILE_NOT_FOUND) continue; // Empty directory (no "." entries on some redirectors)
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_error = "Cannot enumerate " + ToUtf8(m_root / relativeDir) + " (Win32 Error Code: " + std::to_string(error) + ")";
+            m_failed = true;
+            break;
+        }
+
+        size_t firstChildDir = pending.size();
+        do {
+            const wchar_t* name = data.cFileName;
+            if (name[0] == L'.' && (name[1] == L'\0' || (name[1] == L'.' && name[2] == L'\0'))) continue;
+
+            ManifestEntry entry;
+            entry.relativePath = relativeDir / name;
+            entry.attributes = data.dwFileAttributes;
+            entry.lastWriteTime = FileTimeToTicks(data.ftLastWriteTime);
+            entry.isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+
+            if (entry.isDirectory) {
+                if (!(data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) pending.push_back(entry.relativePath);
+            } else {
+                entry.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+                m_bytesDiscovered += entry.size;
+                m_filesDiscovered++;
+            }
+
+            batch.push_back(std::move(entry));
+            if (batch.size() >= kPublishBatch) publish();
+        } while (!m_cancel && FindNextFileW(find, &data));
+        FindClose(find);
+
+        // Keep a natural top-down order: visit subdirectories in the order they were listed.
+        std::reverse(pending.begin() + firstChildDir, pending.end());
+    }
+
+    publish();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_complete = true;
+    }
+    m_entryAvailable.notify_all();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief One file or directory found while scanning a folder job's source tree.
+ * * Size, timestamp and attributes come straight from the directory records, so no
+ * per-file stat is needed later.
+ */
+struct ManifestEntry {
+    std::filesystem::path relativePath; // Relative to the scan root
+    uint64_t size = 0;
+    uint64_t lastWriteTime = 0;         // FILETIME as 100 ns ticks since 1601
+    uint32_t attributes = 0;
+    bool isDirectory = false;
+};
+
+/**
+ * @brief Enumerates a directory tree once, on a background thread, into a manifest.
+ * * Uses FindFirstFileExW with FIND_FIRST_EX_LARGE_FETCH so network shares return many
+ * records per round trip. Consumers can pull entries with Next() while the scan is still
+ * running; directories are always produced before their contents. Consumed entries are
+ * dropped, so memory tracks the backlog rather than the size of the tree.
+ */
+class DirectoryScanner {
+public:
+    /**
+     * @brief Starts scanning root in the background.
+     */
+    explicit DirectoryScanner(const std::filesystem::path& root);
+
+    /**
+     * @brief Stops the scan (if still running) and joins the thread.
+     */
+    ~DirectoryScanner();
+
+    DirectoryScanner(const DirectoryScanner&) = delete;
+    DirectoryScanner& operator=(const DirectoryScanner&) = delete;
+
+    /**
+     * @brief Returns the next manifest entry, blocking until one is available.
+     * @return false once the scan has finished (or failed) and every entry was consumed.
+     */
+    bool Next(ManifestEntry& entry);
+
+    bool IsComplete() const { return m_complete; }
+    bool Failed() const { return m_failed; }
+
+    /**
+     * @brief Description of the enumeration failure. Only valid once Failed() returns true.
+     */
+    const std::string& GetError() const { return m_error; }
+
+    uint64_t GetBytesDiscovered() const { return m_bytesDiscovered; }
+    uint64_t GetFilesDiscovered() const { return m_filesDiscovered; }
+
+private:
+    void ScanLoop();
+
+    std::filesystem::path m_root;
+    std::deque<ManifestEntry> m_entries; // Published but not yet consumed
+    std::string m_error;
+
+    std::atomic<uint64_t> m_bytesDiscovered{ 0 };
+    std::atomic<uint64_t> m_filesDiscovered{ 0 };
+    std::atomic<bool> m_complete{ false };
+    std::atomic<bool> m_failed{ false };
+    std::atomic<bool> m_cancel{ false };
+
+    std::mutex m_mutex;
+    std::condition_variable m_entryAvailable;
+    std::thread m_thread;
+};
@@ -0,0 +1,389 @@
+#include "JobJournal.h"
+#include "../Core/Hash.h"
+#include "../Core/Logger.h"
+#include "../Core/Utf8.h"
+#include <windows.h>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <chrono>
+#include <cstring>
+
+// Every record is framed as [u32 payload length][u32 checksum][payload]. The payload starts
+// with the record type and the job id; the checksum is the low half of its XXH64.
+static constexpr size_t kFrameHeaderSize = 8;
+
+// Writing is kicked early once this much is buffered, to bound memory during huge folder jobs.
+static constexpr size_t kEagerWriteBytes = 1 * 1024 * 1024;
+
+// --- Encoding helpers ---
+
+static void PutU8(std::string& out, uint8_t value) {
+    out.push_back(static_cast<char>(value));
+}
+
+static void PutU64(std::string& out, uint64_t value) {
+    char bytes[sizeof(value)];
+    memcpy(bytes, &value, sizeof(value));
+    out.append(bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Appends a path as a UTF-16 unit count followed by the raw units.
+ */
+static void PutPath(std::string& out, const std::filesystem::path& path) {
+    const std::wstring text = path.wstring();
+    PutU64(out, text.size());
+    out.append(reinterpret_cast<const char*>(text.data()), text.size() * sizeof(wchar_t));
+}
+
+/**
+ * @brief Bounds-checked cursor over one record payload. Any overrun clears ok.
+ */
+struct RecordReader {
+    const char* p;
+    const char* end;
+    bool ok = true;
+
+    uint8_t U8() {
+        if (end - p < 1) { ok = false; return 0; }
+        return static_cast<uint8_t>(*p++);
+    }
+
+    uint64_t U64() {
+        uint64_t value = 0;
+        if (end - p < (ptrdiff_t)sizeof(value)) { ok = false; return 0; }
+        memcpy(&value, p, sizeof(value));
+        p += sizeof(value);
+        return value;
+    }
+
+    std::wstring Path() {
+        uint64_t units = U64();
+        if (!ok || units > (uint64_t)(end - p) / sizeof(wchar_t)) { ok = false; return {}; }
+        std::wstring text(static_cast<size_t>(units), L'\0');
+        memcpy(text.data(), p, text.size() * sizeof(wchar_t));
+        p += text.size() * sizeof(wchar_t);
+        return text;
+    }
+};
+
+/**
+ * @brief Prefixes a payload with its length and checksum.
+ */
+static void AppendFrame(std::string& out, const std::string& payload) {
+    uint32_t header[2] = {
+        static_cast<uint32_t>(payload.size()),
+        static_cast<uint32_t>(Xxh64::Hash(payload.data(), payload.size()))
+    };
+    out.append(reinterpret_cast<const char*>(header), sizeof(header));
+    out.append(payload);
+}
+
+/**
+ * @brief Writes all of data to a file handle.
+ */
+static bool WriteAll(HANDLE file, const std::string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        DWORD bytes = 0;
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(data.size() - done, 64ull * 1024 * 1024));
+        if (!WriteFile(file, data.data() + done, chunk, &bytes, NULL)) return false;
+        done += bytes;
+    }
+    return true;
+}
+
+// --- JobJournal Implementation ---
+
+/**
+ * @brief Remembers the location; nothing is read or written before Open().
+ */
+JobJournal::JobJournal(const std::filesystem::path& path, unsigned int flushIntervalMs)
+    : m_path(path), m_flushIntervalMs(flushIntervalMs > 0 ? flushIntervalMs : 1) {
+}
+
+/**
+ * @brief Writes the remaining records, then closes the file.
+ */
+JobJournal::~JobJournal() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    if (m_writer.joinable()) m_writer.join();
+    if (m_file) CloseHandle(static_cast<HANDLE>(m_file));
+}
+
+/**
+ * @brief Starts a record payload with its type and job id.
+ */
+std::string JobJournal::BeginRecord(RecordType type, uint64_t id) {
+    std::string payload;
+    PutU8(payload, static_cast<uint8_t>(type));
+    PutU64(payload, id);
+    return payload;
+}
+
+/**
+ * @brief Replays the journal, keeps the unfinished jobs and rewrites the file with them.
+ * * Replay stops at the first record that is truncated or fails its checksum; that is the
+ * torn tail of a write interrupted by the crash. The compacted journal is written to a
+ * temporary file and swapped in with MoveFileExW, so a crash during compaction leaves
+ * the old journal intact.
+ * * @param restored Receives the unfinished jobs, oldest first.
+ * @return true if the journal is ready for appending.
+ */
+bool JobJournal::Open(std::vector<JournalJob>& restored) {
+    std::map<uint64_t, JournalJob> jobs;
+    {
+        std::ifstream in(m_path, std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        size_t pos = 0;
+        while (data.size() - pos >= kFrameHeaderSize) {
+            uint32_t header[2];
+            memcpy(header, data.data() + pos, sizeof(header));
+            if (header[0] > data.size() - pos - kFrameHeaderSize) break;
+            const char* payload = data.data() + pos + kFrameHeaderSize;
+            if (static_cast<uint32_t>(Xxh64::Hash(payload, header[0])) != header[1]) break;
+            pos += kFrameHeaderSize + header[0];
+
+            RecordReader reader{ payload, payload + header[0] };
+            RecordType type = static_cast<RecordType>(reader.U8());
+            uint64_t id = reader.U64();
+            if (!reader.ok) continue;
+
+            if (type == RecordType::JobAdded) {
+                JournalJob job;
+                job.id = id;
+                job.type = static_cast<JobType>(reader.U8());
+                job.engine = static_cast<CopyEngine>(reader.U8());
+                job.compare = static_cast<SyncCompare>(reader.U8());
+                job.verify = static_cast<VerifyMode>(reader.U8());
+                job.priority = static_cast<IoPriority>(reader.U8());
+                job.bandwidthLimit = reader.U64();
+                job.source = reader.Path();
+                job.destination = reader.Path();
+                uint64_t batchSize = reader.U64();
+                for (uint64_t i = 0; i < batchSize && reader.ok; i++) job.renameBatch.push_back(reader.Path());
+                if (reader.ok) jobs[id] = std::move(job);
+                continue;
+            }
+
+            auto found = jobs.find(id);
+            if (found == jobs.end()) continue;
+            JournalJob& job = found->second;
+            switch (type) {
+                case RecordType::JobStarted: {
+                    std::wstring resolved = reader.Path();
+                    if (reader.ok) job.resolvedDestination = resolved;
+                    break;
+                }
+                case RecordType::FileDone: {
+                    std::wstring file = reader.Path();
+                    if (!reader.ok) break;
+                    job.partialFiles.erase(file);
+                    job.completedFiles.insert(std::move(file));
+                    break;
+                }
+                case RecordType::FileProgress: {
+                    std::wstring file = reader.Path();
+                    JournalPartialFile progress;
+                    progress.offset = reader.U64();
+                    progress.sourceSize = reader.U64();
+                    progress.sourceTime = reader.U64();
+                    if (reader.ok) job.partialFiles[file] = progress;
+                    break;
+                }
+                case RecordType::JobFinished:
+                case RecordType::JobRemoved:
+                    jobs.erase(found);
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (pos < data.size()) {
+            ButlerLogger::Log(LogLevel::WARN, "Journal: ignored {} bytes of incomplete records at the end of {}",
+                              data.size() - pos, ToUtf8(m_path));
+        }
+    }
+
+    // Rewrite the journal with only what is still needed.
+    std::string compacted;
+    for (auto& [id, job] : jobs) {
+        std::string payload = BeginRecord(RecordType::JobAdded, id);
+        PutU8(payload, static_cast<uint8_t>(job.type));
+        PutU8(payload, static_cast<uint8_t>(job.engine));
+        PutU8(payload, static_cast<uint8_t>(job.compare));
+        PutU8(payload, static_cast<uint8_t>(job.verify));
+        PutU8(payload, static_cast<uint8_t>(job.priority));
+        PutU64(payload, job.bandwidthLimit);
+        PutPath(payload, job.source);
+        PutPath(payload, job.destination);
+        PutU64(payload, job.renameBatch.size());
+        for (const auto& item : job.renameBatch) PutPath(payload, item);
+        AppendFrame(compacted, payload);
+
+        if (!job.resolvedDestination.empty()) {
+            payload = BeginRecord(RecordType::JobStarted, id);
+            PutPath(payload, job.resolvedDestination);
+            AppendFrame(compacted, payload);
+        }
+        for (const auto& file : job.completedFiles) {
+            payload = BeginRecord(RecordType::FileDone, id);
+            PutPath(payload, file);
+            AppendFrame(compacted, payload);
+        }
+        for (const auto& [file, progress] : job.partialFiles) {
+            payload = BeginRecord(RecordType::FileProgress, id);
+            PutPath(payload, file);
+            PutU64(payload, progress.offset);
+            PutU64(payload, progress.sourceSize);
+            PutU64(payload, progress.sourceTime);
+            AppendFrame(compacted, payload);
+        }
+    }
+
+    std::error_code ec;
+    if (m_path.has_parent_path()) std::filesystem::create_directories(m_path.parent_path(), ec);
+
+    std::filesystem::path temporary = m_path;
+    temporary += L".tmp";
+    HANDLE file = CreateFileW(temporary.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    bool compactedOk = file != INVALID_HANDLE_VALUE && WriteAll(file, compacted) && FlushFileBuffers(file);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    compactedOk = compactedOk &&
+        MoveFileExW(temporary.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+    if (!compactedOk) {
+        ButlerLogger::Log(LogLevel::ERR, "Journal: cannot rewrite {} (Win32 Error Code: {}), journaling disabled",
+                          ToUtf8(m_path), GetLastError());
+        DeleteFileW(temporary.c_str());
+        return false;
+    }
+
+    file = CreateFileW(m_path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        ButlerLogger::Log(LogLevel::ERR, "Journal: cannot open {} (Win32 Error Code: {}), journaling disabled",
+                          ToUtf8(m_path), GetLastError());
+        return false;
+    }
+    m_file = file;
+    m_writer = std::thread(&JobJournal::WriterLoop, this);
+
+    restored.clear();
+    for (auto& [id, job] : jobs) restored.push_back(std::move(job));
+    return true;
+}
+
+/**
+ * @brief Frames a record into the write buffer. A no-op if the journal is not open.
+ */
+void JobJournal::Append(const std::string& payload) {
+    if (!m_file) return;
+    bool eager;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        AppendFrame(m_buffer, payload);
+        m_appended++;
+        eager = m_buffer.size() >= kEagerWriteBytes;
+    }
+    if (eager) m_wake.notify_one();
+}
+
+void JobJournal::RecordJobAdded(const FileJob& job) {
+    std::string payload = BeginRecord(RecordType::JobAdded, job.sequence);
+    PutU8(payload, static_cast<uint8_t>(job.type));
+    PutU8(payload, static_cast<uint8_t>(job.engine));
+    PutU8(payload, static_cast<uint8_t>(job.syncCompare));
+    PutU8(payload, static_cast<uint8_t>(job.verify));
+    PutU8(payload, static_cast<uint8_t>(job.priority));
+    PutU64(payload, job.bandwidth.GetRate());
+    PutPath(payload, job.source.Get());
+    PutPath(payload, job.destination.Get());
+    PutU64(payload, job.renameBatch.size());
+    for (const auto& item : job.renameBatch) PutPath(payload, item);
+    Append(payload);
+}
+
+void JobJournal::RecordJobStarted(uint64_t id, const std::filesystem::path& resolvedDestination) {
+    std::string payload = BeginRecord(RecordType::JobStarted, id);
+    PutPath(payload, resolvedDestination);
+    Append(payload);
+}
+
+void JobJournal::RecordFileDone(uint64_t id, const std::filesystem::path& relativePath) {
+    std::string payload = BeginRecord(RecordType::FileDone, id);
+    PutPath(payload, relativePath);
+    Append(payload);
+}
+
+void JobJournal::RecordFileProgress(uint64_t id, const std::filesystem::path& relativePath, const JournalPartialFile& progress) {
+    std::string payload = BeginRecord(RecordType::FileProgress, id);
+    PutPath(payload, relativePath);
+    PutU64(payload, progress.offset);
+    PutU64(payload, progress.sourceSize);
+    PutU64(payload, progress.sourceTime);
+    Append(payload);
+}
+
+void JobJournal::RecordJobFinished(uint64_t id) {
+    Append(BeginRecord(RecordType::JobFinished, id));
+}
+
+void JobJournal::RecordJobRemoved(uint64_t id) {
+    Append(BeginRecord(RecordType::JobRemoved, id));
+}
+
+/**
+ * @brief Blocks until every record appended before the call is on disk.
+ */
+void JobJournal::Flush() {
+    if (!m_file) return;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const uint64_t target = m_appended;
+    m_flushRequested = true;
+    m_wake.notify_one();
+    m_flushed.wait(lock, [&] { return m_written >= target || m_stop; });
+}
+
+/**
+ * @brief Background writer: once per interval (or on demand) writes the buffered records
+ * and syncs the file.
+ * * The buffer is swapped out under the lock, so producers never wait for the disk.
+ */
+void JobJournal::WriterLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait_for(lock, std::chrono::milliseconds(m_flushIntervalMs), [&] {
+            return m_stop || m_flushRequested || m_buffer.size() >= kEagerWriteBytes;
+        });
+
+        std::string data;
+        data.swap(m_buffer);
+        const uint64_t target = m_appended;
+        m_flushRequested = false;
+
+        if (!data.empty()) {
+            lock.unlock();
+            if (!WriteOut(data)) {
+                ButlerLogger::Log(LogLevel::ERR, "Journal: write failed (Win32 Error Code: {})", GetLastError());
+            }
+            lock.lock();
+        }
+        m_written = target;
+        m_flushed.notify_all();
+
+        if (m_stop && m_buffer.empty()) break;
+    }
+}
+
+/**
+ * @brief Appends a batch of framed records and forces them to the device.
+ */
+bool JobJournal::WriteOut(const std::string& data) {
+    HANDLE file = static_cast<HANDLE>(m_file);
+    return WriteAll(file, data) && FlushFileBuffers(file);
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "TransferManager.h"
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+/**
+ * @brief A large file that was only partly copied when the journal stopped.
+ */
+struct JournalPartialFile {
+    uint64_t offset = 0;     // Destination bytes known to be written
+    uint64_t sourceSize = 0; // Source state at that time; a changed source restarts the file
+    uint64_t sourceTime = 0;
+};
+
+/**
+ * @brief An unfinished job as reconstructed from the journal.
+ */
+struct JournalJob {
+    uint64_t id = 0;
+    JobType type = JobType::Copy;
+    CopyEngine engine = CopyEngine::Auto;
+    SyncCompare compare = SyncCompare::Metadata;
+    VerifyMode verify = VerifyMode::None;
+    IoPriority priority = IoPriority::Normal;
+    uint64_t bandwidthLimit = 0; // Bytes per second the job was capped at when queued
+    std::filesystem::path source;
+    std::filesystem::path destination;
+    std::vector<std::filesystem::path> renameBatch; // Items of a same-volume Move batch
+    std::filesystem::path resolvedDestination; // Set once the job started; resumes into the same target
+    std::unordered_set<std::wstring> completedFiles; // Relative paths (the file name for single-file jobs)
+    std::unordered_map<std::wstring, JournalPartialFile> partialFiles;
+};
+
+/**
+ * @brief Append-only on-disk log of the transfer queue.
+ * * Every enqueue, start, finished file, large-file checkpoint, completion and removal
+ * is appended as a checksummed record. Records are buffered and written by a background
+ * thread with one FlushFileBuffers per interval, so a folder job with millions of files
+ * costs one fsync per second rather than one per file. A crash loses at most the last
+ * interval, which only means re-copying those files.
+ * * On startup Open() replays the log, returns the jobs that never finished and rewrites
+ * the file with just those, so it does not grow across sessions.
+ */
+class JobJournal {
+public:
+    /**
+     * @param path Journal file (created if missing).
+     * @param flushIntervalMs Longest time a record stays in memory.
+     */
+    explicit JobJournal(const std::filesystem::path& path, unsigned int flushIntervalMs = 1000);
+
+    /**
+     * @brief Flushes outstanding records and stops the writer thread.
+     */
+    ~JobJournal();
+
+    JobJournal(const JobJournal&) = delete;
+    JobJournal& operator=(const JobJournal&) = delete;
+
+    /**
+     * @brief Replays and compacts the journal, then starts appending.
+     * @param restored Receives the unfinished jobs in enqueue order.
+     * @return false if the journal cannot be written (it is then disabled).
+     */
+    bool Open(std::vector<JournalJob>& restored);
+
+    void RecordJobAdded(const FileJob& job);
+    void RecordJobStarted(uint64_t id, const std::filesystem::path& resolvedDestination);
+    void RecordFileDone(uint64_t id, const std::filesystem::path& relativePath);
+    void RecordFileProgress(uint64_t id, const std::filesystem::path& relativePath, const JournalPartialFile& progress);
+    void RecordJobFinished(uint64_t id);
+    void RecordJobRemoved(uint64_t id);
+
+    /**
+     * @brief Writes and syncs every buffered record before returning.
+     */
+    void Flush();
+
+private:
+    enum class RecordType : uint8_t {
+        JobAdded = 1,
+        JobStarted,
+        FileDone,
+        FileProgress,
+        JobFinished,
+        JobRemoved
+    };
+
+    static std::string BeginRecord(RecordType type, uint64_t id);
+    void Append(const std::string& payload);
+    void WriterLoop();
+    bool WriteOut(const std::string& data);
+
+    std::filesystem::path m_path;
+    unsigned int m_flushIntervalMs;
+    void* m_file = nullptr; // HANDLE; kept opaque so this header stays free of <windows.h>
+
+    std::string m_buffer; // Encoded records not yet written
+    uint64_t m_appended = 0;
+    uint64_t m_written = 0;
+    bool m_flushRequested = false;
+    bool m_stop = false;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_flushed;
+    std::thread m_writer;
+};
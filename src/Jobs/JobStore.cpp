@@ -0,0 +1,174 @@
+#include "JobStore.h"
+#include "../Core/Utf8.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// Arena chunk size; strings longer than this get a chunk of their own.
+static constexpr size_t kArenaChunkSize = 64 * 1024;
+
+std::filesystem::path JobPath::Get() const {
+    if (!folder) return std::filesystem::path(name);
+    if (name.empty()) return folder->path;
+    return folder->path / name;
+}
+
+/**
+ * @brief Returns the store shared by all transfer managers.
+ */
+JobStore& JobStore::Shared() {
+    static JobStore store;
+    return store;
+}
+
+/**
+ * @brief Carves bytes out of the current arena chunk, starting a new chunk when it is full.
+ * Must be called with m_mutex held.
+ */
+void* JobStore::AllocateLocked(size_t bytes, size_t alignment) {
+    size_t offset = (m_chunkUsed + alignment - 1) / alignment * alignment;
+    if (!m_current || offset + bytes > m_current->size) {
+        // A full chunk stays until its last string is released; one with none left goes now
+        if (m_current && m_current->live == 0) m_chunks.erase(m_current->data.get());
+        const size_t size = std::max(bytes, kArenaChunkSize);
+        auto data = std::make_unique<char[]>(size);
+        const char* start = data.get();
+        ArenaChunk& chunk = m_chunks[start];
+        chunk.data = std::move(data);
+        chunk.size = size;
+        m_current = &chunk;
+        offset = 0;
+    }
+    m_chunkUsed = offset + bytes;
+    m_current->live++;
+    return m_current->data.get() + offset;
+}
+
+/**
+ * @brief Returns one string to its chunk and frees the chunk once nothing in it is live.
+ * * The current chunk is rewound instead, so a store that empties out reuses its memory.
+ * Must be called with m_mutex held.
+ */
+void JobStore::FreeLocked(const void* allocation) {
+    if (!allocation) return;
+    const char* address = static_cast<const char*>(allocation);
+    auto it = m_chunks.upper_bound(address);
+    if (it == m_chunks.begin()) return;
+    --it;
+    ArenaChunk& chunk = it->second;
+    if (reinterpret_cast<uintptr_t>(address) >= reinterpret_cast<uintptr_t>(it->first) + chunk.size) return; // Not ours
+    if (--chunk.live > 0) return;
+    if (&chunk == m_current) m_chunkUsed = 0;
+    else m_chunks.erase(it);
+}
+
+/**
+ * @brief Looks up (or adds) a folder and takes a reference to it.
+ * * Keys are exact (case-sensitive), so differently cased spellings of one folder are
+ * stored separately and each is displayed as the user picked it.
+ * Must be called with m_mutex held.
+ */
+const InternedFolder* JobStore::InternFolderLocked(const std::filesystem::path& folder) {
+    auto [it, added] = m_folders.try_emplace(folder.wstring());
+    if (added) {
+        it->second = std::make_unique<InternedFolder>();
+        it->second->path = folder;
+        it->second->display = ToUtf8(folder);
+    }
+    it->second->refs++;
+    return it->second.get();
+}
+
+/**
+ * @brief Drops a reference and frees the folder with its last one.
+ * Must be called with m_mutex held.
+ */
+void JobStore::ReleaseFolderLocked(const InternedFolder* folder) {
+    if (!folder) return;
+    // The store owns every folder it hands out; callers only see them as const
+    auto* entry = const_cast<InternedFolder*>(folder);
+    if (--entry->refs == 0) m_folders.erase(entry->path.wstring());
+}
+
+/**
+ * @brief Returns the single stored copy of a folder path, adding it on first use.
+ */
+const InternedFolder* JobStore::InternFolder(const std::filesystem::path& folder) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return InternFolderLocked(folder);
+}
+
+const InternedFolder* JobStore::RetainFolder(const InternedFolder* folder) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (folder) const_cast<InternedFolder*>(folder)->refs++;
+    return folder;
+}
+
+void JobStore::ReleaseFolder(const InternedFolder* folder) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ReleaseFolderLocked(folder);
+}
+
+/**
+ * @brief Copies a wide name into the arena (NUL-terminated).
+ */
+std::wstring_view JobStore::StoreName(std::wstring_view name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto* copy = static_cast<wchar_t*>(AllocateLocked((name.size() + 1) * sizeof(wchar_t), alignof(wchar_t)));
+    std::copy(name.begin(), name.end(), copy);
+    copy[name.size()] = L'\0';
+    return std::wstring_view(copy, name.size());
+}
+
+/**
+ * @brief Copies a narrow string into the arena and returns it NUL-terminated.
+ */
+const char* JobStore::StoreText(std::string_view text) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto* copy = static_cast<char*>(AllocateLocked(text.size() + 1, 1));
+    memcpy(copy, text.data(), text.size());
+    copy[text.size()] = '\0';
+    return copy;
+}
+
+void JobStore::ReleaseText(const char* text) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FreeLocked(text);
+}
+
+JobPath JobStore::MakePath(const std::filesystem::path& path) {
+    const InternedFolder* folder = InternFolder(path.parent_path());
+    JobPath result = MakePath(folder, path.filename());
+    ReleaseFolder(folder);
+    return result;
+}
+
+JobPath JobStore::MakePath(const InternedFolder* folder, const std::filesystem::path& name) {
+    JobPath result;
+    result.folder = RetainFolder(folder);
+    result.name = StoreName(name.wstring());
+    result.displayName = StoreText(ToUtf8(name));
+    return result;
+}
+
+JobPath JobStore::MakePathIn(const InternedFolder* folder, const std::filesystem::path& target) {
+    std::filesystem::path name = target.lexically_relative(folder->path);
+    // A target on another root is kept whole: folder->path / target is target itself
+    if (name.empty()) name = target;
+    return MakePath(folder, name);
+}
+
+JobPath JobStore::MakeFolderPath(const std::filesystem::path& folder) {
+    JobPath result;
+    result.folder = InternFolder(folder); // The path keeps the reference taken here
+    result.displayName = StoreText(ToUtf8(folder.filename()));
+    return result;
+}
+
+void JobStore::Release(const JobPath& path) {
+    if (!path.folder) return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FreeLocked(path.name.data());
+    FreeLocked(path.displayName);
+    ReleaseFolderLocked(path.folder);
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <map>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+
+/**
+ * @brief A folder path interned in the JobStore, with its display form.
+ */
+struct InternedFolder {
+    std::filesystem::path path;
+    std::string display; // Narrow form shown in the queue table
+    size_t refs = 0;     // Paths and callers holding the folder; guarded by the store's mutex
+};
+
+/**
+ * @brief A job path stored compactly: an interned folder plus a file name in the arena.
+ * * For paths that name a folder themselves (rename batches) the name is empty. The name
+ * may have several components (a target resolved below the folder). A JobPath owns one
+ * reference to its folder and its strings; the owner hands it back with JobStore::Release.
+ */
+struct JobPath {
+    const InternedFolder* folder = nullptr;
+    std::wstring_view name;
+    const char* displayName = ""; // Narrow file name, NUL-terminated
+
+    /**
+     * @brief Rebuilds the full path (allocates; not meant for per-frame use).
+     */
+    std::filesystem::path Get() const;
+};
+
+/**
+ * @brief Process-wide storage for the strings of queued jobs.
+ * * Jobs of one selection share their parent folders, so each folder is stored once and
+ * jobs point at it. File names and other short job strings are packed into large arena
+ * chunks instead of one heap block each.
+ * * Everything is handed back when the job that owns it is destroyed, i.e. once it has
+ * left the queue and no UI snapshot holds it any more. Folders are reference counted and
+ * freed with their last path; an arena chunk is freed once none of its strings is live,
+ * so jobs queued together (and removed together) give their chunk back as a whole.
+ * * All members are thread-safe. Returned pointers and views stay valid until released.
+ */
+class JobStore {
+public:
+    static JobStore& Shared();
+
+    /**
+     * @brief Returns the folder with one reference held for the caller (see ReleaseFolder).
+     */
+    const InternedFolder* InternFolder(const std::filesystem::path& folder);
+    const InternedFolder* RetainFolder(const InternedFolder* folder);
+    void ReleaseFolder(const InternedFolder* folder);
+
+    std::wstring_view StoreName(std::wstring_view name);
+    const char* StoreText(std::string_view text);
+
+    /**
+     * @brief Frees a string returned by StoreText. Pointers the store did not hand out
+     * (e.g. "") are ignored.
+     */
+    void ReleaseText(const char* text);
+
+    /**
+     * @brief Splits a path into its interned parent and its stored file name.
+     */
+    JobPath MakePath(const std::filesystem::path& path);
+
+    /**
+     * @brief Same, with an already interned parent (saves the lookup in bulk enqueues).
+     * The path takes its own reference to folder.
+     */
+    JobPath MakePath(const InternedFolder* folder, const std::filesystem::path& name);
+
+    /**
+     * @brief Stores target as a name relative to folder, so a path resolved below a job's
+     * folder reuses it instead of interning its own parent.
+     */
+    JobPath MakePathIn(const InternedFolder* folder, const std::filesystem::path& target);
+
+    /**
+     * @brief A JobPath naming the folder itself.
+     */
+    JobPath MakeFolderPath(const std::filesystem::path& folder);
+
+    /**
+     * @brief Hands back the folder reference and the strings of a path built by this store.
+     * Default-constructed paths are ignored.
+     */
+    void Release(const JobPath& path);
+
+private:
+    struct ArenaChunk {
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+        size_t live = 0; // Strings carved from this chunk and not yet released
+    };
+
+    void* AllocateLocked(size_t bytes, size_t alignment);
+    void FreeLocked(const void* allocation);
+    const InternedFolder* InternFolderLocked(const std::filesystem::path& folder);
+    void ReleaseFolderLocked(const InternedFolder* folder);
+
+    std::mutex m_mutex;
+    std::unordered_map<std::wstring, std::unique_ptr<InternedFolder>> m_folders; // Node addresses are stable
+    std::map<const char*, ArenaChunk> m_chunks; // By start address, to find an allocation's chunk
+    ArenaChunk* m_current = nullptr;            // Chunk new strings are carved from
+    size_t m_chunkUsed = 0;
+};
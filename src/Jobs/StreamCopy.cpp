@@ -0,0 +1,303 @@
+#include "StreamCopy.h"
+#include "../Core/Hash.h"
+#include "../Core/ThreadPool.h"
+#include "../Core/BufferPool.h"
+#include "../Core/Profiler.h"
+#include "../Core/ScopedHandle.h"
+#include <windows.h>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+
+// Completion keys used to tell reads and writes apart on the shared port.
+static constexpr ULONG_PTR kReadKey = 1;
+static constexpr ULONG_PTR kWriteKey = 2;
+
+static constexpr size_t kMinBlockSize = 1 * 1024 * 1024;
+static constexpr size_t kMaxBlockSize = 8 * 1024 * 1024;
+
+/**
+ * @brief One in-flight block. The OVERLAPPED must stay the first member so a
+ * completion packet can be mapped back to its slot.
+ */
+struct IoSlot {
+    OVERLAPPED ov;
+    BYTE* buffer = nullptr;
+    uint64_t offset = 0;
+    DWORD length = 0; // Valid data bytes in the buffer
+    bool inFlight = false; // A read or write of this slot is outstanding
+    uint64_t issuedAt = 0; // Profiler::Now() when the outstanding operation was issued
+    std::atomic<bool> hashing{ false }; // A hash task still reads the buffer
+};
+
+/**
+ * @brief Rounds a value up to the next multiple of an alignment.
+ */
+static uint64_t RoundUp(uint64_t value, uint64_t alignment) {
+    return ((value + alignment - 1) / alignment) * alignment;
+}
+
+/**
+ * @brief Queries the sector size unbuffered I/O on a handle must be aligned to.
+ * * Falls back to 4 KB (the common physical sector size) if the volume does not report it,
+ * which is typical for network redirectors.
+ */
+static DWORD GetSectorSize(HANDLE file) {
+    FILE_STORAGE_INFO info{};
+    if (GetFileInformationByHandleEx(file, FileStorageInfo, &info, sizeof(info))) {
+        DWORD sector = std::max(info.PhysicalBytesPerSectorForPerformance, info.LogicalBytesPerSector);
+        if (sector > 0) return sector;
+    }
+    return 4096;
+}
+
+/**
+ * @brief Sets the overlapped offset of a slot and clears its completion state.
+ */
+static void PrepareSlot(IoSlot& slot, uint64_t offset) {
+    slot.issuedAt = Profiler::Now();
+    ZeroMemory(&slot.ov, sizeof(slot.ov));
+    slot.offset = offset;
+    slot.ov.Offset = static_cast<DWORD>(offset);
+    slot.ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+}
+
+/**
+ * @brief Copies a file through a pipeline of unbuffered overlapped reads and writes.
+ * * Both handles are bound to one completion port. Every slot cycles
+ * read -> write -> read at the next free offset until the file is exhausted. Writes are
+ * rounded up to the sector size, so the destination is trimmed to the real length
+ * (and given the source's timestamps/attributes) through a buffered handle at the end.
+ * * Writes complete out of order, so progress reports the written prefix: everything below
+ * the lowest offset still in flight. A resumed copy opens the existing destination and
+ * starts reading at the (block-aligned) resume offset.
+ * * With a digest, every block is hashed once its read completes, in parallel with its
+ * write when a pool is given. A slot is only refilled after its hash task is done.
+ * * @param src Source file.
+ * @param dst Destination file (overwritten).
+ * @param options Block size and number of blocks in flight.
+ * @param onProgress Called after each completed write; returning false cancels.
+ * @param digest Receives the source content if not null.
+ * @param hashPool Threads for the block hashes, or nullptr to hash on the calling thread.
+ * @return true on success, false with GetLastError() set otherwise.
+ */
+bool StreamCopyEngine::Copy(const std::filesystem::path& src, const std::filesystem::path& dst,
+                            const StreamCopyOptions& options, const ProgressCallback& onProgress,
+                            ChunkedDigest* digest, ThreadPool* hashPool) {
+    ScopedHandle source{ CreateFileW(src.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED, NULL) };
+    if (!source.Valid()) return false;
+
+    LARGE_INTEGER size;
+    FILE_BASIC_INFO basicInfo;
+    if (!GetFileSizeEx(source.h, &size) ||
+        !GetFileInformationByHandleEx(source.h, FileBasicInfo, &basicInfo, sizeof(basicInfo))) {
+        return false;
+    }
+    const uint64_t totalBytes = static_cast<uint64_t>(size.QuadPart);
+    if (digest) digest->Reset(totalBytes);
+    const bool resuming = options.startOffset > 0;
+
+    uint64_t dataEnd = 0;
+    DWORD error = ERROR_SUCCESS;
+    {
+        const DWORD disposition = resuming ? OPEN_ALWAYS : options.failIfExists ? CREATE_NEW : CREATE_ALWAYS;
+        const uint64_t createStart = Profiler::Now();
+        ScopedHandle dest{ CreateFileW(dst.c_str(), GENERIC_WRITE, 0, NULL, disposition,
+            FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED, NULL) };
+        Profiler::RecordSince(ProfileStage::Create, createStart);
+        if (!dest.Valid()) return false;
+
+        const DWORD sector = std::max(GetSectorSize(source.h), GetSectorSize(dest.h));
+        // Hashed blocks must start on chunk boundaries; the chunk size is itself sector-aligned.
+        const size_t blockSize = static_cast<size_t>(
+            RoundUp(std::clamp(options.blockSize, kMinBlockSize, kMaxBlockSize), digest ? ChunkedDigest::kChunkSize : sector));
+        const unsigned int slotCount = std::max(options.buffersInFlight, 1u);
+
+        uint64_t startOffset = 0;
+        LARGE_INTEGER existing;
+        if (resuming && GetFileSizeEx(dest.h, &existing)) {
+            startOffset = std::min({ options.startOffset, static_cast<uint64_t>(existing.QuadPart), totalBytes });
+            startOffset -= startOffset % blockSize;
+        }
+        dataEnd = startOffset;
+
+        if (options.lowPriority) {
+            // Best effort: some file systems and redirectors ignore the hint.
+            FILE_IO_PRIORITY_HINT_INFO hint{};
+            hint.PriorityHint = IoPriorityHintLow;
+            SetFileInformationByHandle(source.h, FileIoPriorityHintInfo, &hint, sizeof(hint));
+            SetFileInformationByHandle(dest.h, FileIoPriorityHintInfo, &hint, sizeof(hint));
+        }
+
+        // Reserve clusters up front to limit fragmentation (best effort, EOF is unchanged).
+        FILE_ALLOCATION_INFO allocation{};
+        allocation.AllocationSize.QuadPart = static_cast<LONGLONG>(RoundUp(totalBytes, sector));
+        SetFileInformationByHandle(dest.h, FileAllocationInfo, &allocation, sizeof(allocation));
+
+        ScopedHandle port{ CreateIoCompletionPort(source.h, NULL, kReadKey, 1) };
+        if (!port.Valid() || !CreateIoCompletionPort(dest.h, port.h, kWriteKey, 1)) {
+            error = GetLastError();
+        }
+
+        // Pool buffers are page aligned, which satisfies any sector alignment up to 4 KB.
+        // Leasing may wait until other transfers return memory.
+        BufferLease lease;
+        BYTE* arena = nullptr;
+        if (error == ERROR_SUCCESS) {
+            lease = BufferPool::Shared().Acquire(blockSize * slotCount);
+            arena = lease.Data();
+            if (!arena) error = GetLastError();
+        }
+
+        if (error == ERROR_SUCCESS) {
+            std::vector<IoSlot> slots(slotCount);
+            uint64_t nextReadOffset = startOffset;
+            uint64_t writtenPrefix = startOffset;
+            unsigned int outstanding = 0;
+            bool aborted = false;
+
+            auto fail = [&](DWORD reason) {
+                if (aborted) return;
+                aborted = true;
+                error = reason;
+                CancelIoEx(source.h, NULL);
+                CancelIoEx(dest.h, NULL);
+            };
+
+            auto issueRead = [&](IoSlot& slot) {
+                PrepareSlot(slot, nextReadOffset);
+                nextReadOffset += blockSize;
+                if (!ReadFile(source.h, slot.buffer, static_cast<DWORD>(blockSize), NULL, &slot.ov) &&
+                    GetLastError() != ERROR_IO_PENDING) {
+                    fail(GetLastError());
+                    return;
+                }
+                slot.inFlight = true;
+                outstanding++;
+            };
+
+            // Everything below the lowest offset still in flight has been written.
+            auto advancePrefix = [&]() {
+                uint64_t prefix = nextReadOffset;
+                for (const IoSlot& other : slots) {
+                    if (other.inFlight) prefix = std::min(prefix, other.offset);
+                }
+                writtenPrefix = std::max(writtenPrefix, std::min(prefix, totalBytes));
+            };
+
+            auto hashBlock = [&](IoSlot& slot, DWORD validBytes) {
+                if (!digest) return;
+                if (!hashPool) {
+                    digest->AddRange(slot.offset, slot.buffer, validBytes);
+                    return;
+                }
+                slot.hashing = true;
+                hashPool->Submit([digest, &slot, buffer = slot.buffer, offset = slot.offset, validBytes] {
+                    digest->AddRange(offset, buffer, validBytes);
+                    slot.hashing = false;
+                    slot.hashing.notify_all();
+                });
+            };
+
+            auto waitForHash = [](IoSlot& slot) {
+                while (slot.hashing.load()) slot.hashing.wait(true);
+            };
+
+            auto issueWrite = [&](IoSlot& slot, DWORD validBytes) {
+                slot.length = validBytes;
+                DWORD writeBytes = static_cast<DWORD>(RoundUp(validBytes, sector));
+                // Zero the sector padding of the final block; it is trimmed off afterwards.
+                if (writeBytes > validBytes) memset(slot.buffer + validBytes, 0, writeBytes - validBytes);
+                PrepareSlot(slot, slot.offset);
+                if (!WriteFile(dest.h, slot.buffer, writeBytes, NULL, &slot.ov) &&
+                    GetLastError() != ERROR_IO_PENDING) {
+                    fail(GetLastError());
+                    return;
+                }
+                slot.inFlight = true;
+                outstanding++;
+            };
+
+            for (unsigned int i = 0; i < slotCount && nextReadOffset < totalBytes && !aborted; i++) {
+                slots[i].buffer = arena + i * blockSize;
+                issueRead(slots[i]);
+            }
+
+            while (outstanding > 0) {
+                DWORD bytes = 0;
+                ULONG_PTR key = 0;
+                OVERLAPPED* ov = nullptr;
+                BOOL ok = GetQueuedCompletionStatus(port.h, &bytes, &key, &ov, INFINITE);
+                if (!ov) {
+                    // The port itself failed. The kernel still owns the slots and the arena of
+                    // every operation in flight, so cancel them and wait until each one is done
+                    // before they go out of scope; their completions can no longer be dequeued.
+                    fail(GetLastError());
+                    for (IoSlot& pending : slots) {
+                        while (pending.inFlight && !HasOverlappedIoCompleted(&pending.ov)) Sleep(1);
+                        pending.inFlight = false;
+                    }
+                    outstanding = 0;
+                    break;
+                }
+                outstanding--;
+
+                IoSlot& slot = *reinterpret_cast<IoSlot*>(ov);
+                slot.inFlight = false;
+                if (!ok) {
+                    // A read at the end of a file that shrank underneath us is not an error.
+                    if (key == kReadKey && GetLastError() == ERROR_HANDLE_EOF) continue;
+                    fail(GetLastError());
+                    continue;
+                }
+                if (aborted) continue; // Draining after a failure or cancel
+                Profiler::RecordSince(key == kReadKey ? ProfileStage::Read : ProfileStage::Write, slot.issuedAt, bytes);
+
+                if (key == kReadKey) {
+                    if (bytes > 0) {
+                        hashBlock(slot, bytes);
+                        issueWrite(slot, bytes);
+                    }
+                } else {
+                    dataEnd = std::max(dataEnd, slot.offset + slot.length);
+                    advancePrefix();
+                    if (onProgress && !onProgress(writtenPrefix, totalBytes)) {
+                        fail(ERROR_REQUEST_ABORTED);
+                        continue;
+                    }
+                    if (nextReadOffset < totalBytes) {
+                        waitForHash(slot);
+                        issueRead(slot);
+                    }
+                }
+            }
+
+            // Hash tasks read the arena; it must outlive them.
+            for (IoSlot& slot : slots) waitForHash(slot);
+        }
+
+    }
+
+    if (error == ERROR_SUCCESS) {
+        // Trim the sector padding and apply the source metadata through a buffered handle.
+        // Scoped so the handle is closed before a failed copy is deleted below.
+        ScopedHandle fixup{ CreateFileW(dst.c_str(), GENERIC_WRITE | FILE_WRITE_ATTRIBUTES, 0, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL) };
+        FILE_END_OF_FILE_INFO eof{};
+        eof.EndOfFile.QuadPart = static_cast<LONGLONG>(dataEnd);
+        if (!fixup.Valid() ||
+            !SetFileInformationByHandle(fixup.h, FileEndOfFileInfo, &eof, sizeof(eof)) ||
+            !SetFileInformationByHandle(fixup.h, FileBasicInfo, &basicInfo, sizeof(basicInfo))) {
+            error = GetLastError();
+        }
+    }
+
+    if (error != ERROR_SUCCESS) {
+        if (!resuming) DeleteFileW(dst.c_str());
+        SetLastError(error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <cstdint>
+
+class ChunkedDigest;
+class ThreadPool;
+
+/**
+ * @brief Tuning knobs of the unbuffered streaming engine.
+ */
+struct StreamCopyOptions {
+    size_t blockSize = 4 * 1024 * 1024; // Bytes per I/O; clamped to 1-8 MB and rounded to the sector size
+    unsigned int buffersInFlight = 4;   // Number of blocks kept in flight at once
+    // Resume: keep this many leading bytes of an existing destination and copy the rest.
+    // Rounded down to the block size and to the destination's current length.
+    uint64_t startOffset = 0;
+    // Issue all reads and writes with the low I/O priority hint (background transfers).
+    bool lowPriority = false;
+    // Create the destination with CREATE_NEW: an existing file fails the copy with
+    // ERROR_FILE_EXISTS and is left untouched. Ignored when resuming.
+    bool failIfExists = false;
+};
+
+/**
+ * @brief Large-file copy engine built on unbuffered, overlapped I/O.
+ * * Opens both files with FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED so multi-GB
+ * transfers bypass the system cache, and keeps several sector-aligned blocks in flight
+ * so the read of one block overlaps the write of another.
+ * * Copies file data, attributes and timestamps. Alternate data streams and security
+ * descriptors are not copied; use CopyFileExW when those matter.
+ */
+class StreamCopyEngine {
+public:
+    /**
+     * @brief Invoked after every completed write with (bytesDone, totalBytes). bytesDone is
+     * the length of the destination prefix that is completely written, including a resumed
+     * part, so it is a safe restart point. Returning false cancels the copy. May block
+     * (e.g. while the queue is paused).
+     */
+    using ProgressCallback = std::function<bool(uint64_t, uint64_t)>;
+
+    /**
+     * @brief Copies src to dst, overwriting dst if it exists (or continuing it, see startOffset).
+     * @param src Source file.
+     * @param dst Destination file.
+     * @param options Block size and pipeline depth.
+     * @param onProgress Optional progress/cancel callback.
+     * @param digest Optional; receives the source content as it streams through (see ChunkedDigest).
+     * @param hashPool Optional; threads hashing the blocks while their writes are in flight.
+     * @return true on success. On failure the partial destination is deleted and
+     * GetLastError() holds the Win32 error (ERROR_REQUEST_ABORTED when cancelled). A resumed
+     * destination is kept on failure so it can be resumed again.
+     */
+    static bool Copy(const std::filesystem::path& src, const std::filesystem::path& dst,
+                     const StreamCopyOptions& options, const ProgressCallback& onProgress = nullptr,
+                     ChunkedDigest* digest = nullptr, ThreadPool* hashPool = nullptr);
+};
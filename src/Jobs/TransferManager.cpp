@@ -1,55 +1,206 @@
 #include "TransferManager.h"
+#include "DirectoryScan.h"
+#include "JobJournal.h"
+#include "CloneCopy.h"
+#include "DestinationNames.h"
 #include "../Core/Logger.h"
+#include "../Core/ThreadPool.h"
+#include "../Core/Hash.h"
+#include "../Core/VolumeInfo.h"
+#include "../Core/Profiler.h"
+#include "../Core/Utf8.h"
 #include <windows.h>
 #include <iostream>
 #include <algorithm>
+#include <unordered_map>
+#include <cwctype>
+#include <chrono>
 
 // --- Helper Functions ---
 
+// Files up to this size are copied concurrently inside folder jobs.
+static constexpr uint64_t kParallelCopyMaxFileSize = 4ull * 1024 * 1024;
+
+// Journaled jobs checkpoint a large file each time this many more bytes have been written.
+static constexpr uint64_t kJournalCheckpointBytes = 256ull * 1024 * 1024;
+
+// Fresh names tried for one job target before giving up when each turns out to be taken.
+static constexpr int kMaxNameAttempts = 16;
+
+// Largest last-write time difference (100 ns ticks) a Sync job still treats as equal.
+// FAT and exFAT store timestamps with 2 second granularity.
+static constexpr uint64_t kSyncTimeTolerance = 2ull * 10000000;
+
 /**
- * @brief Recursively calculates the total size of a directory.
- * * Iterates through the given directory and all its subdirectories, summing the size
- * of all regular files found. Exceptions (e.g., permission denied) are caught and ignored.
- * * @param dir The directory path to scan.
- * @return uint64_t Total size in bytes.
+ * @brief True if a failed create or rename was refused because the name is in use.
  */
-uint64_t GetDirectorySize(const std::filesystem::path& dir) {
-    uint64_t size = 0;
-    try {
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
-            if (entry.is_regular_file()) {
-                size += entry.file_size();
-            }
-        }
-    } catch (...) {}
-    return size;
+static bool IsNameTaken(DWORD error) {
+    return error == ERROR_FILE_EXISTS || error == ERROR_ALREADY_EXISTS;
+}
+
+/**
+ * @brief Returns the scheduling key of the volume a path lives on.
+ * * Uses the upper-cased root name ("C:", "\\server") so that "c:\a" and "C:\b"
+ * are recognised as the same drive.
+ * * @param p Any absolute path.
+ * @return std::wstring The volume key (empty for relative paths).
+ */
+static std::wstring GetVolumeKey(const std::filesystem::path& p) {
+    std::wstring root = p.root_name().wstring();
+    std::transform(root.begin(), root.end(), root.begin(), ::towupper);
+    return root;
+}
+
+/**
+ * @brief Returns a case-insensitive lookup key for a path (Windows paths ignore case).
+ */
+static std::wstring GetPathKey(const std::filesystem::path& p) {
+    std::wstring key = p.wstring();
+    std::transform(key.begin(), key.end(), key.begin(), ::towupper);
+    return key;
+}
+
+/**
+ * @brief Reads size, last-write time and attributes of a single file or directory.
+ * * @param p The path to query.
+ * @param entry Receives the metadata (relativePath is left untouched).
+ * @return false if the path does not exist or cannot be queried.
+ */
+static bool StatPath(const std::filesystem::path& p, ManifestEntry& entry) {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(p.c_str(), GetFileExInfoStandard, &data)) return false;
+    entry.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    entry.lastWriteTime = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+    entry.attributes = data.dwFileAttributes;
+    entry.isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    return true;
+}
+
+/**
+ * @brief Blocks the calling thread while a job is paused.
+ * * Called between files and from the copy callbacks, so jobs halt promptly when the
+ * queue is paused. Sleeps on the status atomic itself (C++20 atomic wait); whoever
+ * changes a Paused status must call notify_all() on it.
+ * * @param job The job to check.
+ */
+static void WaitWhilePaused(const FileJob& job) {
+    while (job.status.load() == JobStatus::Paused) job.status.wait(JobStatus::Paused);
 }
 
 /**
- * @brief Generates a unique file path to prevent overwriting existing files.
- * * If the target path already exists, this function appends a counter (e.g., "File (1).txt")
- * until a unique path is found.
- * * @param target The desired destination path.
- * @return std::filesystem::path A unique path that does not currently exist.
+ * @brief Deletes a file or an empty folder, clearing a read-only attribute if that is
+ * what prevents it.
+ * * @param path File or folder to delete.
+ * @param isDirectory Whether path is a folder.
+ * @return true if it was deleted; otherwise GetLastError() describes the failure.
  */
-std::filesystem::path GetUniquePath(std::filesystem::path target) {
-    if (!std::filesystem::exists(target)) return target;
-    std::filesystem::path folder = target.parent_path();
-    std::filesystem::path stem = target.stem();
-    std::filesystem::path ext = target.extension();
-    int counter = 1;
-    while (std::filesystem::exists(target)) {
-        std::string newName = stem.string() + " (" + std::to_string(counter) + ")" + ext.string();
-        target = folder / newName;
-        counter++;
+static bool DeleteSourcePath(const std::filesystem::path& path, bool isDirectory) {
+    ProfileScope deleteScope(ProfileStage::Delete);
+    auto remove = [&] { return (isDirectory ? RemoveDirectoryW(path.c_str()) : DeleteFileW(path.c_str())) != FALSE; };
+    if (remove()) return true;
+    if (GetLastError() != ERROR_ACCESS_DENIED) return false;
+
+    DWORD attributes = GetFileAttributesW(path.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_READONLY)) {
+        SetLastError(ERROR_ACCESS_DENIED);
+        return false;
     }
-    return target;
+    SetFileAttributesW(path.c_str(), attributes & ~FILE_ATTRIBUTE_READONLY);
+    return remove();
 }
 
+/**
+ * @brief Returns where an interrupted unbuffered copy of a restored job can continue.
+ * * The checkpoint is only trusted if the source still has the size and timestamp it had
+ * when the checkpoint was taken.
+ * * @param job The job (only restored Copy/Move jobs carry checkpoints).
+ * @param src Source file.
+ * @param relativePath Name of the file within the job.
+ * @return The byte offset to resume at, or 0 to copy from the start.
+ */
+static uint64_t GetResumeOffset(const FileJob& job, const std::filesystem::path& src, const std::filesystem::path& relativePath) {
+    if (!job.resume || job.type == JobType::Sync) return 0;
+    auto found = job.resume->partialFiles.find(relativePath.wstring());
+    if (found == job.resume->partialFiles.end()) return 0;
+
+    ManifestEntry now;
+    const JournalPartialFile& checkpoint = found->second;
+    if (!StatPath(src, now) || now.size != checkpoint.sourceSize || now.lastWriteTime != checkpoint.sourceTime) return 0;
+    return checkpoint.offset;
+}
+
+/**
+ * @brief Compares two files by their content digest. Both files are read in full.
+ * * @param job The owning job; hashing halts between blocks while it is paused.
+ * @param hashPool Threads hashing the blocks while further ones are read.
+ * @return true if both files could be read and hash the same.
+ */
+static bool HaveSameContent(const FileJob& job, const std::filesystem::path& a, const std::filesystem::path& b,
+                            ThreadPool* hashPool) {
+    auto onBlock = [&job](uint64_t) {
+        WaitWhilePaused(job);
+        return true;
+    };
+    uint64_t hashA = 0, hashB = 0;
+    return ChunkedDigest::HashFile(a, hashA, hashPool, false, onBlock) &&
+           ChunkedDigest::HashFile(b, hashB, hashPool, false, onBlock) && hashA == hashB;
+}
+
+/**
+ * @brief Per-file progress state handed to CopyProgressRoutine.
+ * * Copy callbacks report the bytes done for one file; the context turns those into
+ * deltas for the job so parallel copies can share one byte counter. The same deltas are
+ * charged to the job's and the global bandwidth buckets: the engines call back once per
+ * block and wait for the next one, so blocking here paces the copy loop.
+ */
+struct CopyProgressContext {
+    FileJob* job;
+    TokenBucket* globalBandwidth; // Manager-wide cap, charged along with the job's own; null = unthrottled
+    uint64_t reported = 0;
+    uint64_t base = 0; // Bytes of a resumed file that were already there (never credited)
+
+    void Report(uint64_t fileBytesDone) {
+        if (fileBytesDone <= reported) return;
+        uint64_t delta = fileBytesDone - reported;
+        job->AddTransferredBytes(static_cast<int64_t>(delta));
+        reported = fileBytesDone;
+        if (globalBandwidth) {
+            job->bandwidth.Acquire(delta);
+            globalBandwidth->Acquire(delta);
+        }
+    }
+
+    // Takes back the bytes of a file that failed part-way.
+    void Rollback() {
+        if (reported <= base) return;
+        job->AddTransferredBytes(-static_cast<int64_t>(reported - base));
+        reported = base;
+    }
+};
+
+/**
+ * @brief Puts the calling thread into background processing mode for its lifetime.
+ * * In background mode the thread's I/O is issued at very low priority (and its CPU and
+ * memory priority drop too), which covers CopyFileExW and the delta engine whose handles
+ * we do not own. Only leaves the mode if it entered it, so nesting is harmless.
+ */
+struct BackgroundIoScope {
+    bool active = false;
+
+    explicit BackgroundIoScope(IoPriority priority) {
+        if (priority == IoPriority::Background) active = SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN) != FALSE;
+    }
+    ~BackgroundIoScope() {
+        if (active) SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+    }
+    BackgroundIoScope(const BackgroundIoScope&) = delete;
+    BackgroundIoScope& operator=(const BackgroundIoScope&) = delete;
+};
+
 /**
  * @brief Callback function used by Windows CopyFileEx API.
- * * Currently serves as a placeholder to allow the copy operation to continue.
- * Future implementations can use this to update file-level progress for large single files.
+ * * Forwards the byte count of the current file to its job, which keeps progress live
+ * for large single files, and halts mid-file while the job is paused.
  */
 DWORD CALLBACK CopyProgressRoutine(
     LARGE_INTEGER TotalFileSize,
@@ -62,216 +213,1151 @@ DWORD CALLBACK CopyProgressRoutine(
     HANDLE hDestinationFile,
     LPVOID lpData
 ) {
+    auto* context = static_cast<CopyProgressContext*>(lpData);
+    if (context) {
+        context->Report(static_cast<uint64_t>(TotalBytesTransferred.QuadPart));
+        WaitWhilePaused(*context->job);
+    }
     return PROGRESS_CONTINUE; 
 }
 
+// --- FileJob Implementation ---
+
+/**
+ * @brief Returns the job's paths (and a batch's display name) to the job store.
+ */
+FileJob::~FileJob() {
+    JobStore& store = JobStore::Shared();
+    store.Release(source);
+    store.Release(destination);
+    if (!renameBatch.empty()) store.ReleaseText(displayName); // Stored by EnqueueLocked
+}
+
+// Minimum interval between two throughput samples.
+static constexpr uint64_t kThroughputSampleMs = 250;
+
+/**
+ * @brief Accounts transferred bytes and updates progress and throughput.
+ * * The hot path is one relaxed atomic add plus a tick read. At most one caller per
+ * sample interval wins the compare-exchange and folds the rate since the previous sample
+ * into an exponential moving average.
+ * * @param delta Bytes written since the last report (negative to roll back a failed file).
+ */
+void FileJob::AddTransferredBytes(int64_t delta) {
+    uint64_t done = bytesTransferred.fetch_add(static_cast<uint64_t>(delta), std::memory_order_relaxed) + static_cast<uint64_t>(delta);
+    uint64_t total = bytesTotal.load(std::memory_order_relaxed);
+    if (total > 0) progress = std::min(1.0f, (float)done / (float)total);
+
+    uint64_t now = GetTickCount64();
+    uint64_t last = lastSampleTick.load(std::memory_order_relaxed);
+    if (now - last < kThroughputSampleMs || !lastSampleTick.compare_exchange_strong(last, now)) return;
+
+    uint64_t previousBytes = lastSampleBytes.exchange(done);
+    if (done < previousBytes) return;
+    float instant = (float)(done - previousBytes) * 1000.0f / (float)(now - last);
+    float average = throughput;
+    throughput = (average == 0.0f) ? instant : average * 0.7f + instant * 0.3f;
+}
+
+/**
+ * @brief Estimates the remaining time from the rolling throughput.
+ * * @return double Seconds left, or -1.0 if no rate has been measured yet.
+ */
+double FileJob::GetEtaSeconds() const {
+    float rate = throughput;
+    uint64_t total = bytesTotal;
+    uint64_t done = bytesTransferred;
+    if (rate <= 0.0f || total == 0) return -1.0;
+    return (done >= total) ? 0.0 : (double)(total - done) / rate;
+}
+
+/**
+ * @brief Copies the digest records under the lock, so the UI can read them mid-job.
+ */
+std::vector<FileDigest> FileJob::GetDigests() const {
+    std::lock_guard<std::mutex> lock(digestMutex);
+    return digests;
+}
+
 // --- TransferManager Implementation ---
 
 /**
- * @brief Constructs the TransferManager and starts the worker thread.
+ * @brief Constructs the TransferManager and starts the worker pool.
+ * * Since same-volume jobs are serialized, threads beyond the number of distinct
+ * drives in use simply idle, so the default stays small. Digests of verified jobs are
+ * computed on a separate pool sized to the CPU, as hashing is CPU-bound.
+ * * @param workerCount Number of worker threads (0 = min(hardware threads, 4)).
  */
-TransferManager::TransferManager() {
-    m_workerThread = std::thread(&TransferManager::WorkerLoop, this);
+TransferManager::TransferManager(unsigned int workerCount) {
+    m_snapshot.store(std::make_shared<const QueueSnapshot>());
+    m_hashPool = std::make_unique<ThreadPool>(std::clamp(std::thread::hardware_concurrency(), 2u, 8u));
+    // Large pages cut TLB misses on the multi-MB transfer buffers; most accounts lack the privilege.
+    if (BufferPool::Shared().EnableLargePages()) ButlerLogger::Log(LogLevel::INFO, "Transfer buffers use large pages");
+    if (workerCount == 0) {
+        workerCount = std::clamp(std::thread::hardware_concurrency(), 1u, 4u);
+    }
+    for (unsigned int i = 0; i < workerCount; i++) {
+        m_workers.emplace_back(&TransferManager::WorkerLoop, this);
+    }
 }
 
 /**
- * @brief Destructor. Signals the worker thread to stop and joins it.
+ * @brief Destructor. Signals all worker threads to stop and joins them.
+ * * Paused jobs are resumed first, otherwise their workers would never return.
  */
 TransferManager::~TransferManager() {
-    m_stopThread = true;
-    if (m_workerThread.joinable()) m_workerThread.join();
+    ResumeQueue();
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_stopThread = true;
+    }
+    m_workAvailable.notify_all();
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) worker.join();
+    }
 }
 
 /**
  * @brief Adds a new file operation job to the queue.
- * * Pre-calculates the final destination path (handling directory merging) immediately
- * so the UI displays the correct target before the job starts processing.
  * * @param src Source path.
  * @param dest Destination directory.
- * @param type Operation type (Copy or Move).
+ * @param type Operation type (Copy, Move or Sync).
+ * @param engine Copy engine for the job's files.
+ * @param compare Change detection used by Sync jobs.
+ * @param verify Digest/read-back mode for the job's files.
+ * @param priority I/O priority.
+ * @param bandwidthLimit Per-job rate cap (0 = unlimited).
  */
-void TransferManager::QueueJob(const std::filesystem::path& src, const std::filesystem::path& dest, JobType type) {
+void TransferManager::QueueJob(const std::filesystem::path& src, const std::filesystem::path& dest, JobType type,
+                               CopyEngine engine, SyncCompare compare, VerifyMode verify, IoPriority priority,
+                               uint64_t bandwidthLimit) {
+    QueueJobs(std::span<const std::filesystem::path>(&src, 1), dest, type, engine, compare, verify, priority, bandwidthLimit);
+}
+
+/**
+ * @brief Adds a batch of jobs sharing a destination.
+ * * Pre-calculates the final destination paths (handling directory merging) immediately
+ * so the UI displays the correct target before the jobs start processing. The file system
+ * is only touched once, for the destination, and before the queue lock is taken; the jobs
+ * are built outside the lock too. Sources of one selection usually share their folder,
+ * which is then interned only once.
+ * * @param sources Source paths.
+ * @param dest Destination directory (or full target path for a single source).
+ */
+void TransferManager::QueueJobs(std::span<const std::filesystem::path> sources, const std::filesystem::path& dest,
+                                JobType type, CopyEngine engine, SyncCompare compare, VerifyMode verify,
+                                IoPriority priority, uint64_t bandwidthLimit) {
+    if (sources.empty()) return;
+    JobStore& store = JobStore::Shared();
+    const bool intoFolder = std::filesystem::is_directory(dest);
+    const InternedFolder* destFolder = intoFolder ? store.InternFolder(dest) : nullptr;
+
+    std::vector<std::shared_ptr<FileJob>> jobs;
+    jobs.reserve(sources.size());
+    const InternedFolder* sourceFolder = nullptr;
+    for (const auto& src : sources) {
+        std::filesystem::path parent = src.parent_path();
+        if (!sourceFolder || sourceFolder->path != parent) {
+            const InternedFolder* next = store.InternFolder(parent);
+            store.ReleaseFolder(sourceFolder); // The jobs built so far hold their own references
+            sourceFolder = next;
+        }
+
+        auto job = std::make_shared<FileJob>();
+        job->source = store.MakePath(sourceFolder, src.filename());
+        job->destination = intoFolder ? store.MakePath(destFolder, src.filename()) : store.MakePath(dest);
+        job->type = type;
+        job->engine = engine;
+        job->syncCompare = compare;
+        job->verify = verify;
+        job->priority = priority;
+        job->bandwidth.SetRate(bandwidthLimit);
+        jobs.push_back(std::move(job));
+    }
+    store.ReleaseFolder(sourceFolder);
+    store.ReleaseFolder(destFolder);
+
     std::lock_guard<std::mutex> lock(m_queueMutex);
+    for (const auto& job : jobs) {
+        job->sequence = m_nextSequence++;
+        EnqueueLocked(job);
+        if (m_journal) m_journal->RecordJobAdded(*job);
+    }
+}
+
+/**
+ * @brief Splits a multi-selection move into one rename batch and regular moves.
+ * * A single same-volume item needs no batch; it is queued as a plain Move, which renames too.
+ * The destination volume is resolved once, and each source folder once for all the items
+ * in it, so a large selection costs a handful of volume lookups rather than two per item.
+ * * @param sources Items to move.
+ * @param destDir Destination folder.
+ * @param verify Verify mode for cross-volume moves.
+ * @param priority I/O priority of every resulting job.
+ * @param bandwidthLimit Per-job cap of the cross-volume moves.
+ */
+void TransferManager::QueueMoves(const std::vector<std::filesystem::path>& sources, const std::filesystem::path& destDir,
+                                 VerifyMode verify, IoPriority priority, uint64_t bandwidthLimit) {
+    const VolumeCapabilities destVolume = VolumeInfo::Query(destDir);
+    std::map<std::wstring, bool> sameVolumeByParent; // Keyed by GetPathKey(parent)
+    std::vector<std::filesystem::path> renames, transfers;
+    for (const auto& src : sources) {
+        const std::filesystem::path parent = src.parent_path();
+        auto [it, added] = sameVolumeByParent.try_emplace(GetPathKey(parent), false);
+        if (added) it->second = VolumeInfo::SameVolume(VolumeInfo::Query(parent), destVolume);
+        (it->second ? renames : transfers).push_back(src);
+    }
+    if (renames.size() == 1) transfers.push_back(renames.front());
+    QueueJobs(transfers, destDir, JobType::Move, CopyEngine::Auto, SyncCompare::Metadata, verify, priority, bandwidthLimit);
+    if (renames.size() < 2) return;
+
     auto job = std::make_shared<FileJob>();
-    job->source = src;
-    
-    // Logic to determine full path if destination is a directory
-    std::filesystem::path finalDest = dest;
-    if (std::filesystem::is_directory(finalDest)) {
-        finalDest /= src.filename();
+    job->source = JobStore::Shared().MakeFolderPath(renames.front().parent_path());
+    job->destination = JobStore::Shared().MakeFolderPath(destDir);
+    job->type = JobType::Move;
+    job->priority = priority;
+    job->renameBatch = std::move(renames);
+
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    job->sequence = m_nextSequence++;
+    EnqueueLocked(job);
+    if (m_journal) m_journal->RecordJobAdded(*job);
+}
+
+/**
+ * @brief Opens the journal and re-queues the jobs it holds.
+ * * Must run before the queue is started: workers read m_journal without further
+ * synchronization once they have claimed a job under m_queueMutex.
+ * * @param path Journal file.
+ * @return size_t Number of restored jobs (0 if the journal could not be opened).
+ */
+size_t TransferManager::EnableJournal(const std::filesystem::path& path) {
+    auto journal = std::make_unique<JobJournal>(path);
+    std::vector<JournalJob> restored;
+    if (!journal->Open(restored)) return 0;
+
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_journal = std::move(journal);
+    for (JournalJob& entry : restored) {
+        auto job = std::make_shared<FileJob>();
+        JobStore& store = JobStore::Shared();
+        job->source = entry.renameBatch.empty() ? store.MakePath(entry.source) : store.MakeFolderPath(entry.source);
+        job->destination = entry.renameBatch.empty() ? store.MakePath(entry.destination) : store.MakeFolderPath(entry.destination);
+        job->type = entry.type;
+        job->engine = entry.engine;
+        job->syncCompare = entry.compare;
+        job->verify = entry.verify;
+        job->priority = entry.priority;
+        job->bandwidth.SetRate(entry.bandwidthLimit);
+        job->renameBatch = std::move(entry.renameBatch);
+        job->sequence = entry.id;
+        m_nextSequence = std::max(m_nextSequence, entry.id + 1);
+        job->resume = std::make_shared<const JournalJob>(std::move(entry));
+        EnqueueLocked(job);
     }
-    job->destination = finalDest;
+    if (!restored.empty()) ButlerLogger::Log(LogLevel::INFO, "Journal: restored {} unfinished job(s)", restored.size());
+    return restored.size();
+}
 
-    job->type = type; 
+/**
+ * @brief Derives volume keys and display strings, then makes the job visible and claimable.
+ * * @param job A fully configured job with its sequence set.
+ */
+void TransferManager::EnqueueLocked(const std::shared_ptr<FileJob>& job) {
+    job->sourceVolume = GetVolumeKey(job->source.folder->path);
+    job->destVolume = GetVolumeKey(job->destination.folder->path);
+    job->displayName = job->renameBatch.empty() ? job->source.displayName
+                                                : JobStore::Shared().StoreText(std::to_string(job->renameBatch.size()) + " items");
+    job->displayFrom = job->source.folder->display.c_str();
+    job->displayTo = job->destination.folder->display.c_str();
     job->status = JobStatus::Pending;
     m_queue.push_back(job);
+    m_pendingByVolumes[{ job->sourceVolume, job->destVolume }].push_back(job);
+    m_pendingCount++;
+    m_queueVersion++;
+    m_snapshotDirty = true;
+    m_workAvailable.notify_one();
+    NotifyStateChanged();
 }
 
 /**
- * @brief Sets the running flag to true, allowing the worker loop to process jobs.
+ * @brief Sets the running flag to true and wakes the workers to process jobs.
  */
-void TransferManager::StartQueue() { if (!m_running) m_running = true; }
+void TransferManager::StartQueue() {
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_running = true;
+    }
+    m_workAvailable.notify_all();
+    NotifyStateChanged();
+}
 
 /**
- * @brief Pauses all currently active copying jobs.
+ * @brief Pauses all currently active copying or deleting jobs and stops workers from
+ * claiming new ones.
  * * The worker loop checks this flag during recursive operations to halt progress.
+ * Workers write a job's final status without the queue lock, so the status only flips
+ * to Paused by compare-exchange: a job that just completed stays completed. The phase
+ * it was paused in is kept in resumeStatus for ResumeQueue().
  */
 void TransferManager::PauseQueue() { 
-    m_paused = true; 
     std::lock_guard<std::mutex> lock(m_queueMutex);
-    for (auto& job : m_queue) {
-        if (job->status == JobStatus::Copying) job->status = JobStatus::Paused;
+    m_paused = true; 
+    for (auto& job : m_activeJobs) {
+        for (JobStatus phase : { JobStatus::Copying, JobStatus::Deleting }) {
+            JobStatus expected = phase;
+            if (job->status.compare_exchange_strong(expected, JobStatus::Paused)) {
+                job->resumeStatus = phase;
+                break;
+            }
+        }
     }
+    NotifyStateChanged();
 }
 
 /**
- * @brief Resumes all paused jobs.
+ * @brief Resumes all paused jobs and wakes the threads blocked on them, as well as the
+ * workers waiting to claim pending jobs.
  */
 void TransferManager::ResumeQueue() { 
-    m_paused = false; 
-    std::lock_guard<std::mutex> lock(m_queueMutex);
-    for (auto& job : m_queue) {
-        if (job->status == JobStatus::Paused) job->status = JobStatus::Copying;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_paused = false; 
+        for (auto& job : m_activeJobs) {
+            JobStatus expected = JobStatus::Paused;
+            if (job->status.compare_exchange_strong(expected, job->resumeStatus)) job->status.notify_all();
+        }
     }
+    m_workAvailable.notify_all();
+    NotifyStateChanged();
 }
 
 /**
  * @brief Removes a job from the queue by index.
- * * Prevents removal if the job is currently being processed (Copying state).
+ * * Prevents removal while the job is being processed by a worker. Pending jobs are
+ * also dropped from the dispatch index.
  * * @param index The index of the job in the deque.
  */
 void TransferManager::RemoveJob(int index) {
     std::lock_guard<std::mutex> lock(m_queueMutex);
     if (index < 0 || index >= m_queue.size()) return;
     auto job = m_queue[index];
-    if (job->status != JobStatus::Copying) {
-        m_queue.erase(m_queue.begin() + index);
+    if (std::find(m_activeJobs.begin(), m_activeJobs.end(), job) != m_activeJobs.end()) return;
+
+    if (job->status == JobStatus::Pending) {
+        auto bucket = m_pendingByVolumes.find({ job->sourceVolume, job->destVolume });
+        if (bucket != m_pendingByVolumes.end()) {
+            auto& jobs = bucket->second;
+            jobs.erase(std::remove(jobs.begin(), jobs.end(), job), jobs.end());
+            if (jobs.empty()) m_pendingByVolumes.erase(bucket);
+        }
+        m_pendingCount--;
     }
+    m_queue.erase(m_queue.begin() + index);
+    if (m_journal) m_journal->RecordJobRemoved(job->sequence);
+    m_queueVersion++;
+    m_snapshotDirty = true;
+    NotifyStateChanged();
 }
 
 /**
- * @brief The main worker loop running in a background thread.
- * * Continuously checks for pending jobs. If a job is found, it executes the transfer logic:
- * 1. Checks if the source is a file or folder.
- * 2. Resolves unique destination paths.
- * 3. Handles Move vs Copy logic, including cross-drive optimizations.
- * 4. Updates progress and status (Pending -> Copying -> Completed/Failed).
+ * @brief Returns the published queue snapshot, republishing it first if the queue changed.
+ * * The steady-state path is a flag check plus an atomic shared_ptr load. Only the first call
+ * after a structural change takes the queue lock to copy the job list.
+ * * @return std::shared_ptr<const QueueSnapshot> The current snapshot (never null).
+ */
+std::shared_ptr<const QueueSnapshot> TransferManager::GetSnapshot() const {
+    if (m_snapshotDirty.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        if (m_snapshotDirty) {
+            auto snapshot = std::make_shared<QueueSnapshot>();
+            snapshot->version = m_queueVersion;
+            snapshot->jobs.assign(m_queue.begin(), m_queue.end());
+            m_snapshot.store(std::move(snapshot), std::memory_order_release);
+            m_snapshotDirty = false;
+        }
+    }
+    return m_snapshot.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Claims the oldest pending job that does not share a volume with an active job.
+ * * Only the front of each volume bucket is a candidate (jobs within a bucket share their
+ * volumes, so they can only run in order), making the cost proportional to the number of
+ * distinct volume pairs rather than the queue length. The job is flagged as Copying and its
+ * volumes are marked busy before the lock is released.
+ * * @return std::shared_ptr<FileJob> The claimed job, or nullptr if none is runnable.
+ */
+std::shared_ptr<FileJob> TransferManager::ClaimNextJob() {
+    auto best = m_pendingByVolumes.end();
+    for (auto it = m_pendingByVolumes.begin(); it != m_pendingByVolumes.end(); ++it) {
+        const auto& [sourceVolume, destVolume] = it->first;
+        if (m_busyVolumes[sourceVolume] > 0 || m_busyVolumes[destVolume] > 0) continue;
+        if (best == m_pendingByVolumes.end() || it->second.front()->sequence < best->second.front()->sequence) best = it;
+    }
+    if (best == m_pendingByVolumes.end()) return nullptr;
+
+    std::shared_ptr<FileJob> job = best->second.front();
+    best->second.pop_front();
+    if (best->second.empty()) m_pendingByVolumes.erase(best);
+    m_pendingCount--;
+
+    m_busyVolumes[job->sourceVolume]++;
+    if (job->destVolume != job->sourceVolume) m_busyVolumes[job->destVolume]++;
+    m_activeJobs.push_back(job);
+    job->status = JobStatus::Copying;
+    NotifyStateChanged();
+    return job;
+}
+
+/**
+ * @brief Returns the volumes of a finished job to the scheduler and updates the counters.
+ * * @param job The job that just completed or failed.
+ */
+void TransferManager::ReleaseJob(const std::shared_ptr<FileJob>& job) {
+    m_busyVolumes[job->sourceVolume]--;
+    if (job->destVolume != job->sourceVolume) m_busyVolumes[job->destVolume]--;
+    m_activeJobs.erase(std::remove(m_activeJobs.begin(), m_activeJobs.end(), job), m_activeJobs.end());
+
+    if (job->status == JobStatus::Failed) m_failedCount++;
+    else m_completedCount++;
+    if (m_journal) m_journal->RecordJobFinished(job->sequence);
+    NotifyStateChanged();
+}
+
+void TransferManager::NotifyStateChanged() const {
+    if (StateObserver observer = m_stateObserver.load(std::memory_order_acquire)) observer();
+}
+
+/**
+ * @brief The worker loop run by each thread of the pool.
+ * * Sleeps on m_workAvailable until a job can be claimed, so queued jobs start without
+ * polling delay and an idle pool consumes no CPU. The queue stops by itself once no
+ * pending job is left and every worker has finished its current job.
  */
 void TransferManager::WorkerLoop() {
     ButlerLogger::Log(LogLevel::INFO, "Worker Thread Started.");
 
-    while (!m_stopThread) {
+    while (true) {
         std::shared_ptr<FileJob> currentJob = nullptr;
-        bool pendingJobsExist = false;
+
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_workAvailable.wait(lock, [&] {
+                if (m_stopThread) return true;
+                if (!m_running || m_paused) return false;
+                currentJob = ClaimNextJob();
+                if (currentJob) return true;
+                if (m_activeJobs.empty() && m_pendingCount == 0) m_running = false;
+                return false;
+            });
+            if (!currentJob) break; // Shutdown requested
+        }
+
+        ProcessJob(currentJob);
 
         {
             std::lock_guard<std::mutex> lock(m_queueMutex);
-            if (m_running && !m_queue.empty()) {
-                for (auto& job : m_queue) {
-                    if (job->status == JobStatus::Pending) {
-                        currentJob = job;
-                        pendingJobsExist = true;
-                        break;
+            ReleaseJob(currentJob);
+        }
+        // The freed volumes may unblock jobs another worker skipped.
+        m_workAvailable.notify_all();
+    }
+}
+
+/**
+ * @brief Executes a single transfer job on the calling worker thread.
+ * * 1. Checks if the source is a file or folder.
+ * 2. Resolves unique destination paths (Sync jobs merge into the existing target instead).
+ * 3. Handles Move vs Copy logic, including cross-drive optimizations. Sync runs the copy
+ *    paths but leaves files that are already up to date alone.
+ * 4. Updates progress and status (Copying -> Completed/Failed).
+ * * @param currentJob The job claimed by ClaimNextJob().
+ */
+void TransferManager::ProcessJob(const std::shared_ptr<FileJob>& currentJob) {
+    const bool isSync = (currentJob->type == JobType::Sync);
+    const bool isBatch = !currentJob->renameBatch.empty();
+    const char* opName = (currentJob->type == JobType::Move) ? "MOVE" : isSync ? "SYNC" : "COPY";
+    const std::filesystem::path jobSource = currentJob->source.Get();
+    ButlerLogger::Log(LogLevel::INFO, "Processing {}: {}", opName, ToUtf8(jobSource));
+    BackgroundIoScope backgroundIo(currentJob->priority);
+
+    currentJob->bytesTransferred = 0;
+    currentJob->throughput = 0.0f;
+    currentJob->lastSampleBytes = 0;
+    currentJob->lastSampleTick = GetTickCount64();
+    currentJob->filesSkipped = 0;
+    currentJob->bytesSkipped = 0;
+    currentJob->filesVerified = 0;
+    currentJob->verifyFailures = 0;
+    currentJob->filesDeleted = 0;
+    {
+        std::lock_guard<std::mutex> lock(currentJob->digestMutex);
+        currentJob->digests.clear();
+    }
+
+    // Resolve Destination and handle duplicates. A sync updates the target in place, a rename
+    // batch resolves each item on its own, and a restored job continues in the target its
+    // interrupted run had created. Any other target gets a name reserved in memory against
+    // the cached folder listing; it is claimed atomically when the target is created.
+    std::filesystem::path finalDest = currentJob->destination.Get();
+    std::filesystem::path requestedDest;
+    // The resolved target is kept as a name below the queued destination folder, so a run
+    // stores one short name and no folder, and nothing at all if the name was free.
+    auto setDestination = [&currentJob](const std::filesystem::path& target) {
+        if (target == currentJob->destination.Get()) return;
+        JobStore& store = JobStore::Shared();
+        JobPath resolved = store.MakePathIn(currentJob->destination.folder, target);
+        store.Release(currentJob->destination);
+        currentJob->destination = resolved;
+    };
+    const JournalJob* resume = currentJob->resume.get();
+    const bool isFolder = std::filesystem::is_directory(jobSource);
+    DestinationNames& names = DestinationNames::Shared();
+    if (resume && !resume->resolvedDestination.empty()) {
+        finalDest = resume->resolvedDestination;
+        setDestination(finalDest);
+    } else if (!isSync && !isBatch) {
+        if (isFolder || std::filesystem::is_directory(finalDest)) {
+            if (std::filesystem::exists(finalDest)) {
+                finalDest /= jobSource.filename();
+            }
+        }
+        requestedDest = finalDest;
+        finalDest = names.Reserve(requestedDest);
+        setDestination(finalDest);
+    }
+    const bool reserved = !requestedDest.empty();
+    currentJob->createNew = reserved && !isFolder;
+    if (m_journal) m_journal->RecordJobStarted(currentJob->sequence, finalDest);
+
+    // Called after a create or rename of the reserved target failed: if the name was taken
+    // behind the listing's back, reserve the next free one and report true to try again.
+    int nameAttempts = 0;
+    auto retryWithNewName = [&]() {
+        if (!reserved || !IsNameTaken(GetLastError()) || ++nameAttempts >= kMaxNameAttempts) return false;
+        names.Release(finalDest, true);
+        finalDest = names.Reserve(requestedDest);
+        setDestination(finalDest);
+        if (m_journal) m_journal->RecordJobStarted(currentJob->sequence, finalDest);
+        ButlerLogger::Log(LogLevel::INFO, "Target name was taken, using {}", ToUtf8(finalDest));
+        return true;
+    };
+
+    // Volume capabilities are cached per volume, so this costs two path lookups per job.
+    // Mount points and UNC shares are compared by volume, not by drive letter.
+    VolumeCapabilities destCaps = VolumeInfo::Query(finalDest.parent_path());
+    currentJob->sameVolume = VolumeInfo::SameVolume(VolumeInfo::Query(jobSource), destCaps);
+    currentJob->cloneClusterSize = (currentJob->sameVolume && destCaps.blockCloning) ? destCaps.clusterSize : 0;
+    currentJob->hardLinks = currentJob->sameVolume && destCaps.hardLinks;
+    const bool sameDrive = currentJob->sameVolume;
+
+    bool success = false;
+    
+    // CASE 0: Batch of same-volume moves (one rename per item)
+    if (isBatch) {
+        success = RenameBatch(currentJob, finalDest);
+    }
+    // CASE 1: Folder Move on Same Drive (Instant Rename)
+    else if (isFolder && currentJob->type == JobType::Move && sameDrive) {
+         do {
+             success = MoveFileWithProgressW(jobSource.c_str(), finalDest.c_str(), NULL, NULL, MOVEFILE_COPY_ALLOWED | MOVEFILE_WRITE_THROUGH);
+         } while (!success && retryWithNewName());
+         if (success) currentJob->progress = 1.0f;
+    }
+    // CASE 2: Single File Operation
+    else if (!isFolder) {
+        std::error_code ec;
+        uint64_t fileSize = std::filesystem::file_size(jobSource, ec);
+        currentJob->bytesTotal = ec ? 0 : fileSize;
+
+        if (isSync) {
+            ManifestEntry source, target;
+            source.relativePath = jobSource.filename();
+            success = StatPath(jobSource, source) &&
+                      SyncFile(currentJob, jobSource, finalDest, source, StatPath(finalDest, target) ? &target : nullptr);
+        } else if (currentJob->type == JobType::Copy || !sameDrive) {
+            do {
+                success = TransferFile(currentJob, jobSource, finalDest, currentJob->bytesTotal, jobSource.filename());
+            } while (!success && retryWithNewName());
+        } else {
+            CopyProgressContext context{ currentJob.get(), &m_globalBandwidth };
+            do {
+                success = MoveFileWithProgressW(jobSource.c_str(), finalDest.c_str(), CopyProgressRoutine, &context, MOVEFILE_COPY_ALLOWED);
+            } while (!success && retryWithNewName());
+        }
+        if (currentJob->verifyFailures > 0) currentJob->SetError("Verification failed: the copy does not match the source");
+        // Cleanup source if it was a cross-drive move (only reached once the copy verified)
+        if (success && currentJob->type == JobType::Move && !sameDrive) {
+            std::filesystem::remove(jobSource);
+        }
+    }
+    // CASE 3: Recursive Folder Copy/Move (Cross-Drive)
+    else {
+        try {
+            ButlerLogger::Log(LogLevel::INFO, "Scanning folder: {}", ToUtf8(jobSource));
+
+            // The tree is enumerated once on a background thread; copying starts with the
+            // first entries while the rest of the scan is still in flight.
+            // Progress is measured against the bytes discovered so far.
+            DirectoryScanner scanner(jobSource);
+
+            // A sync first indexes what the target already holds, while the source scan
+            // runs alongside. One enumeration replaces a stat call per file.
+            std::unordered_map<std::wstring, ManifestEntry> existing;
+            if (isSync && std::filesystem::is_directory(finalDest)) {
+                DirectoryScanner targetScanner(finalDest);
+                ManifestEntry targetEntry;
+                while (targetScanner.Next(targetEntry)) {
+                    existing.emplace(GetPathKey(targetEntry.relativePath), std::move(targetEntry));
+                }
+                if (targetScanner.Failed()) throw std::runtime_error(targetScanner.GetError());
+            }
+
+            // A reserved target folder is claimed with CreateDirectoryW, which fails instead of
+            // merging into a folder that appeared since the listing was taken.
+            if (reserved) {
+                std::filesystem::create_directories(finalDest.parent_path());
+                const uint64_t createStart = Profiler::Now();
+                while (!CreateDirectoryW(finalDest.c_str(), NULL)) {
+                    DWORD error = GetLastError();
+                    if (!retryWithNewName()) {
+                        throw std::runtime_error("Cannot create " + ToUtf8(finalDest) + " (Win32 Error Code: " +
+                                                 std::to_string(error) + ")");
                     }
                 }
+                Profiler::RecordSince(ProfileStage::Create, createStart);
             }
-            if (m_running && !pendingJobsExist && !currentJob) m_running = false;
+            std::filesystem::create_directories(finalDest);
+
+            // Small files are handed to a bounded pool so their open/create latency overlaps.
+            // Large files stay on this thread to avoid interleaving several big streams.
+            // Declared after the scanner so queued copies drain before it goes out of scope.
+            // A move deletes each source file right after its copy landed, on the thread that
+            // copied it, so the cleanup runs in parallel with the copy. Folders are removed at
+            // the end; a file that failed to copy keeps its folder (and the job fails).
+            const bool isMove = (currentJob->type == JobType::Move);
+            std::vector<std::pair<size_t, std::filesystem::path>> sourceFolders;
+            std::atomic<uint64_t> moveFailures{ 0 };
+            std::atomic<uint64_t> syncFailures{ 0 };
+
+            unsigned int concurrency = m_folderCopyConcurrency;
+            std::unique_ptr<ThreadPool> pool;
+            if (concurrency > 1) pool = std::make_unique<ThreadPool>(concurrency, concurrency * 4);
+
+            ManifestEntry entry;
+            while (scanner.Next(entry)) {
+                WaitWhilePaused(*currentJob);
+                currentJob->bytesTotal = scanner.GetBytesDiscovered() - currentJob->bytesSkipped;
+
+                std::filesystem::path targetPath = finalDest / entry.relativePath;
+
+                if (entry.isDirectory) {
+                    std::filesystem::create_directories(targetPath);
+                    if (isMove) {
+                        size_t depth = std::distance(entry.relativePath.begin(), entry.relativePath.end());
+                        sourceFolders.emplace_back(depth, jobSource / entry.relativePath);
+                    }
+                } else {
+                    // A restored job skips files its earlier run finished, as long as they are still there
+                    ManifestEntry landed;
+                    if (resume && !isSync && resume->completedFiles.count(entry.relativePath.wstring()) &&
+                        StatPath(targetPath, landed) && landed.size == entry.size) {
+                        currentJob->filesSkipped++;
+                        currentJob->bytesSkipped += entry.size;
+                        // Landed before the interruption but not yet deleted
+                        if (isMove && DeleteSourcePath(jobSource / entry.relativePath, false)) currentJob->filesDeleted++;
+                        continue;
+                    }
+
+                    const ManifestEntry* target = nullptr;
+                    if (isSync) {
+                        auto found = existing.find(GetPathKey(entry.relativePath));
+                        if (found != existing.end()) target = &found->second;
+                    }
+
+                    auto copyFile = [this, currentJob, isSync, isMove, &moveFailures, &syncFailures,
+                                     sourcePath = jobSource / entry.relativePath, targetPath, source = entry, target]() {
+                        WaitWhilePaused(*currentJob);
+                        BackgroundIoScope backgroundIo(currentJob->priority);
+                        if (isSync) {
+                            if (!SyncFile(currentJob, sourcePath, targetPath, source, target)) {
+                                syncFailures++;
+                                ButlerLogger::Log(LogLevel::WARN, "Could not sync file (Win32 Error Code: {}): {}",
+                                                  GetLastError(), ToUtf8(sourcePath));
+                            }
+                            return;
+                        }
+                        if (!TransferFile(currentJob, sourcePath, targetPath, source.size, source.relativePath)) {
+                            if (isMove) moveFailures++;
+                            return;
+                        }
+                        if (m_journal) m_journal->RecordFileDone(currentJob->sequence, source.relativePath);
+                        if (!isMove) return;
+                        if (DeleteSourcePath(sourcePath, false)) {
+                            currentJob->filesDeleted++;
+                        } else {
+                            ButlerLogger::Log(LogLevel::WARN, "Could not delete moved file (Win32 Error Code: {}): {}",
+                                              GetLastError(), ToUtf8(sourcePath));
+                        }
+                    };
+
+                    if (pool && entry.size <= kParallelCopyMaxFileSize) pool->Submit(std::move(copyFile));
+                    else copyFile();
+                }
+            }
+            if (pool) pool->Wait();
+            if (scanner.Failed()) throw std::runtime_error(scanner.GetError());
+            currentJob->bytesTotal = scanner.GetBytesDiscovered() - currentJob->bytesSkipped;
+            // Checked before a Move removes its source folders
+            if (currentJob->verifyFailures > 0) {
+                throw std::runtime_error(std::to_string(currentJob->verifyFailures.load()) + " file(s) failed verification");
+            }
+            if (moveFailures > 0) {
+                throw std::runtime_error(std::to_string(moveFailures.load()) + " file(s) could not be moved; their sources were kept");
+            }
+            if (syncFailures > 0) {
+                throw std::runtime_error(std::to_string(syncFailures.load()) + " file(s) could not be synced");
+            }
+            
+            success = true;
+            if (isMove) {
+                success = RemoveSourceFolders(currentJob, sourceFolders, pool.get());
+            }
+
+        } catch (const std::exception& e) {
+            currentJob->SetError(e.what());
+            success = false;
         }
+    }
 
-        if (!currentJob) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            continue;
+    if (success) {
+        currentJob->status = JobStatus::Completed;
+        currentJob->progress = 1.0f;
+        ButlerLogger::Log(LogLevel::INFO, "{} SUCCESS: {}", opName, ToUtf8(finalDest));
+        if (isSync) {
+            ButlerLogger::Log(LogLevel::INFO, "SYNC skipped {} unchanged file(s), {} bytes", currentJob->filesSkipped.load(),
+                              currentJob->bytesSkipped.load());
         }
+    } else {
+        currentJob->status = JobStatus::Failed;
+        if (!currentJob->HasError()) {
+            currentJob->SetError("Win32 Error Code: " + std::to_string(GetLastError()));
+        }
+        ButlerLogger::Log(LogLevel::ERR, "{} FAILED: {}", opName, currentJob->GetError());
+    }
 
-        currentJob->status = JobStatus::Copying;
-        std::string opName = (currentJob->type == JobType::Move) ? "MOVE" : "COPY";
-        ButlerLogger::Log(LogLevel::INFO, "Processing " + opName + ": " + currentJob->source.string());
+    if (reserved) {
+        std::error_code ec;
+        names.Release(finalDest, success || std::filesystem::exists(finalDest, ec));
+    }
+}
 
-        // Resolve Destination and handle duplicates
-        std::filesystem::path finalDest = currentJob->destination;
-        if (std::filesystem::is_directory(finalDest) || std::filesystem::is_directory(currentJob->source)) {
-            if (std::filesystem::exists(finalDest)) {
-                finalDest /= currentJob->source.filename();
-            }
+/**
+ * @brief Removes the (by now empty) source folders of a folder move.
+ * * Files were already deleted as their copies landed. Folders go deepest level first,
+ * a whole level at a time: every folder of a level is independent, so a level is spread
+ * over the pool, and it must be gone before its parents can be removed.
+ * The queue can be paused in this phase too; removals halt between folders.
+ * * @param job The move job; its status is Deleting and its progress counts folders meanwhile.
+ * @param directories Depth and path of every folder below the source root (reordered).
+ * @param pool Threads for the removals, or nullptr to remove them on this thread.
+ * @return true if every folder and the root were removed (the job error is set otherwise).
+ */
+bool TransferManager::RemoveSourceFolders(const std::shared_ptr<FileJob>& job,
+                                          std::vector<std::pair<size_t, std::filesystem::path>>& directories,
+                                          ThreadPool* pool) {
+    {
+        // Under the queue lock, so a pause racing with the phase change is not lost
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        job->resumeStatus = JobStatus::Deleting;
+        job->status = m_paused ? JobStatus::Paused : JobStatus::Deleting;
+    }
+    job->progress = 0.0f;
+    NotifyStateChanged();
+    std::sort(directories.begin(), directories.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    const size_t total = directories.size() + 1; // + the root
+    std::atomic<size_t> removed{ 0 };
+    std::atomic<size_t> failed{ 0 };
+    auto removeFolder = [&job, &removed, &failed, total](const std::filesystem::path& folder) {
+        WaitWhilePaused(*job);
+        if (DeleteSourcePath(folder, true)) {
+            job->progress = static_cast<float>(++removed) / static_cast<float>(total);
+        } else {
+            failed++;
         }
-        finalDest = GetUniquePath(finalDest);
-        currentJob->destination = finalDest; 
-
-        bool isFolder = std::filesystem::is_directory(currentJob->source);
-        bool success = false;
-        
-        // CASE 1: Folder Move on Same Drive (Instant Rename)
-        bool sameDrive = (currentJob->source.root_name() == finalDest.root_name());
-
-        if (isFolder && currentJob->type == JobType::Move && sameDrive) {
-             success = MoveFileWithProgressW(currentJob->source.c_str(), finalDest.c_str(), NULL, NULL, MOVEFILE_COPY_ALLOWED | MOVEFILE_WRITE_THROUGH);
-             if (success) currentJob->progress = 1.0f;
+    };
+
+    for (size_t begin = 0; begin < directories.size();) {
+        size_t end = begin;
+        while (end < directories.size() && directories[end].first == directories[begin].first) end++;
+        for (size_t i = begin; i < end; i++) {
+            if (pool) pool->Submit([&removeFolder, &folder = directories[i].second] { removeFolder(folder); });
+            else removeFolder(directories[i].second);
         }
-        // CASE 2: Single File Operation
-        else if (!isFolder) {
-            BOOL cancel = FALSE;
-            if (currentJob->type == JobType::Copy || !sameDrive) {
-                success = CopyFileExW(currentJob->source.c_str(), finalDest.c_str(), CopyProgressRoutine, currentJob.get(), &cancel, 0);
-            } else {
-                success = MoveFileWithProgressW(currentJob->source.c_str(), finalDest.c_str(), CopyProgressRoutine, currentJob.get(), MOVEFILE_COPY_ALLOWED);
+        if (pool) pool->Wait();
+        begin = end;
+    }
+    removeFolder(job->source.Get());
+
+    if (failed > 0) {
+        job->SetError(std::to_string(failed.load()) + " source folder(s) could not be removed");
+        return false;
+    }
+    ButlerLogger::Log(LogLevel::INFO, "MOVE cleanup: {} file(s) and {} folder(s) removed", job->filesDeleted.load(), total);
+    return true;
+}
+
+/**
+ * @brief Renames the items of a Move batch one by one.
+ * * Renames only touch metadata, so progress counts items rather than bytes. A name taken
+ * in the destination gets a numbered variant, as for single moves; the whole batch
+ * resolves its names against one listing of the destination folder. Items of a restored
+ * batch that are already gone were moved by the interrupted run and are skipped.
+ * * @param job The batch job.
+ * @param destDir Folder the items are moved into.
+ * @return true if every item was moved.
+ */
+bool TransferManager::RenameBatch(const std::shared_ptr<FileJob>& job, const std::filesystem::path& destDir) {
+    const size_t total = job->renameBatch.size();
+    DestinationNames& names = DestinationNames::Shared();
+    size_t failed = 0;
+    DWORD lastError = ERROR_SUCCESS;
+    for (size_t i = 0; i < total; i++) {
+        WaitWhilePaused(*job);
+        const std::filesystem::path& src = job->renameBatch[i];
+        std::error_code ec;
+        if (job->resume && !std::filesystem::exists(src, ec)) {
+            job->filesSkipped++;
+        } else {
+            // The rename does not replace, so a name taken since the listing was read is
+            // detected atomically and the next free variant is tried.
+            const std::filesystem::path wanted = destDir / src.filename();
+            std::filesystem::path target = names.Reserve(wanted);
+            bool moved = MoveFileExW(src.c_str(), target.c_str(), 0) != FALSE;
+            for (int attempt = 1; !moved && IsNameTaken(GetLastError()) && attempt < kMaxNameAttempts; attempt++) {
+                names.Release(target, true);
+                target = names.Reserve(wanted);
+                moved = MoveFileExW(src.c_str(), target.c_str(), 0) != FALSE;
             }
-            // Cleanup source if it was a cross-drive move
-            if (success && currentJob->type == JobType::Move && !sameDrive) {
-                std::filesystem::remove(currentJob->source);
+            if (!moved) lastError = GetLastError();
+            names.Release(target, moved);
+            if (!moved) {
+                failed++;
+                ButlerLogger::Log(LogLevel::WARN, "Rename failed (Win32 Error Code: {}): {}", lastError, ToUtf8(src));
             }
         }
-        // CASE 3: Recursive Folder Copy/Move (Cross-Drive)
-        else {
-            try {
-                currentJob->status = JobStatus::Calculating; 
-                ButlerLogger::Log(LogLevel::INFO, "Calculating folder size: " + currentJob->source.string());
-                
-                uint64_t totalBytes = GetDirectorySize(currentJob->source);
-                uint64_t bytesCopied = 0;
-
-                currentJob->status = JobStatus::Copying;
-                std::filesystem::create_directories(finalDest);
-
-                for (const auto& entry : std::filesystem::recursive_directory_iterator(currentJob->source)) {
-                    // Check for pause state
-                    while (currentJob->status == JobStatus::Paused) std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-                    std::filesystem::path relative = std::filesystem::relative(entry.path(), currentJob->source);
-                    std::filesystem::path targetPath = finalDest / relative;
-
-                    if (entry.is_directory()) {
-                        std::filesystem::create_directories(targetPath);
-                    } else {
-                        BOOL c = FALSE;
-                        if (CopyFileExW(entry.path().c_str(), targetPath.c_str(), NULL, NULL, &c, 0)) {
-                            bytesCopied += entry.file_size();
-                            if (totalBytes > 0) currentJob->progress = (float)bytesCopied / (float)totalBytes;
-                        }
-                    }
-                }
-                
-                success = true;
-                if (currentJob->type == JobType::Move) {
-                    currentJob->status = JobStatus::Calculating; // Cleanup phase
-                    std::filesystem::remove_all(currentJob->source);
-                }
+        job->progress = static_cast<float>(i + 1) / static_cast<float>(total);
+    }
+
+    if (failed > 0) {
+        job->SetError(std::to_string(failed) + " of " + std::to_string(total) +
+                      " item(s) could not be moved (Win32 Error Code: " + std::to_string(lastError) + ")");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Links or clones a file when source and destination share a capable volume.
+ * * A hard link is only made for CopyEngine::HardLink and only if the destination does
+ * not exist yet (an existing target is copied over as usual). Block clones are used by
+ * CopyEngine::Auto and as the HardLink fallback; on failure the file is copied normally.
+ * Neither moves data, so neither is throttled.
+ * * @param job The owning job (volume capabilities, progress, pause state).
+ * @param src Source file.
+ * @param dst Destination file.
+ * @param fileSize Size of the source file in bytes.
+ * @return true if the fast path produced the destination.
+ */
+bool TransferManager::TryFastCopy(const std::shared_ptr<FileJob>& job, const std::filesystem::path& src,
+                                  const std::filesystem::path& dst, uint64_t fileSize) {
+    CopyProgressContext context{ job.get(), nullptr };
+    bool done = false;
+    if (job->engine == CopyEngine::HardLink && job->hardLinks) {
+        done = CreateHardLinkW(dst.c_str(), src.c_str(), NULL) != FALSE;
+    }
+    if (!done && job->cloneClusterSize > 0 && fileSize > 0 &&
+        (job->engine == CopyEngine::Auto || job->engine == CopyEngine::HardLink)) {
+        done = BlockCloneEngine::Copy(src, dst, job->cloneClusterSize, [&](uint64_t bytesDone, uint64_t) {
+            context.Report(bytesDone);
+            WaitWhilePaused(*job);
+            return true;
+        }, job->createNew);
+        if (!done) {
+            context.Rollback();
+            ButlerLogger::Log(LogLevel::WARN, "Block clone failed (Win32 Error Code: {}), copying instead: {}",
+                              GetLastError(), ToUtf8(src));
+        }
+    }
+    if (!done) return false;
+
+    context.Report(fileSize);
+    return true;
+}
+
+/**
+ * @brief Copies a single file using the job's engine.
+ * * CopyEngine::Auto picks the unbuffered streaming engine for files above the global
+ * threshold so multi-GB transfers do not thrash the system cache. If the streaming engine
+ * fails (e.g. a filesystem that rejects FILE_FLAG_NO_BUFFERING) the copy is retried once
+ * through CopyFileExW. Bytes are credited to the job as they land and taken back if the
+ * file ultimately fails.
+ * * A digest is taken from the streaming engine's buffers as they pass through, hashed on
+ * the hash pool. CopyFileExW does not expose its data, so after such a copy the source is
+ * hashed again; it was just read, which normally means it is served from the cache.
+ * * With a journal, the unbuffered engine's written prefix is checkpointed every
+ * kJournalCheckpointBytes. Those writes bypass the cache, so a checkpoint never runs
+ * ahead of the data on the device. A restored job resumes such a file at its checkpoint;
+ * the bytes already there count as skipped.
+ * * For FileJob::createNew every engine refuses an existing target; the call then fails
+ * with ERROR_FILE_EXISTS (or ERROR_ALREADY_EXISTS) and leaves that file untouched.
+ * * @param job The owning job (for progress and pause state).
+ * @param src Source file.
+ * @param dst Destination file.
+ * @param fileSize Size of the source file in bytes (0 if unknown).
+ * @param relativePath Name of the file within the job.
+ * @param sourceDigest Receives the source digest if not null.
+ * @return true on success.
+ */
+bool TransferManager::CopyFileWithEngine(const std::shared_ptr<FileJob>& job, const std::filesystem::path& src,
+                                         const std::filesystem::path& dst, uint64_t fileSize,
+                                         const std::filesystem::path& relativePath, uint64_t* sourceDigest) {
+    // A link or clone moves no data, so a requested digest is read from the source
+    if (TryFastCopy(job, src, dst, fileSize)) {
+        return !sourceDigest || ChunkedDigest::HashFile(src, *sourceDigest, m_hashPool.get());
+    }
+
+    CopyProgressContext context{ job.get(), &m_globalBandwidth };
+    bool unbuffered = (job->engine == CopyEngine::Unbuffered) ||
+                      (job->engine == CopyEngine::Auto && fileSize >= m_unbufferedThreshold);
+
+    if (unbuffered) {
+        StreamCopyOptions options = m_streamOptions;
+        options.lowPriority = (job->priority == IoPriority::Background);
+        options.failIfExists = job->createNew;
+        options.startOffset = GetResumeOffset(*job, src, relativePath);
+        if (options.startOffset > 0) {
+            ButlerLogger::Log(LogLevel::INFO, "Resuming at byte {}: {}", options.startOffset, ToUtf8(src));
+            context.reported = context.base = options.startOffset;
+            job->bytesSkipped += options.startOffset;
+            job->bytesTotal -= std::min<uint64_t>(job->bytesTotal, options.startOffset);
+        }
+
+        JournalPartialFile checkpoint;
+        ManifestEntry sourceState;
+        const bool journaled = m_journal && job->type != JobType::Sync && StatPath(src, sourceState);
+        checkpoint.sourceSize = sourceState.size;
+        checkpoint.sourceTime = sourceState.lastWriteTime;
 
-            } catch (const std::exception& e) {
-                currentJob->errorMessage = e.what();
-                success = false;
+        // A resumed copy only streams part of the file, so its digest is taken separately.
+        ChunkedDigest streamed;
+        const bool streamDigest = sourceDigest && options.startOffset == 0;
+        bool copied = StreamCopyEngine::Copy(src, dst, options, [&](uint64_t done, uint64_t) {
+            context.Report(done);
+            if (journaled && done >= checkpoint.offset + kJournalCheckpointBytes) {
+                checkpoint.offset = done;
+                m_journal->RecordFileProgress(job->sequence, relativePath, checkpoint);
             }
+            WaitWhilePaused(*job);
+            return true;
+        }, streamDigest ? &streamed : nullptr, m_hashPool.get());
+        if (copied) {
+            if (streamDigest) *sourceDigest = streamed.Finish();
+            else if (sourceDigest) return ChunkedDigest::HashFile(src, *sourceDigest, m_hashPool.get());
+            return true;
         }
 
-        if (success) {
-            currentJob->status = JobStatus::Completed;
-            currentJob->progress = 1.0f;
-            ButlerLogger::Log(LogLevel::INFO, opName + " SUCCESS: " + finalDest.string());
+        DWORD error = GetLastError();
+        context.Rollback();
+        if (job->createNew && IsNameTaken(error)) {
+            SetLastError(error);
+            return false;
+        }
+        ButlerLogger::Log(LogLevel::WARN, "Unbuffered copy failed (Win32 Error Code: {}), retrying with CopyFileExW: {}",
+                          error, ToUtf8(src));
+    }
+
+    BOOL cancel = FALSE;
+    const uint64_t copyStart = Profiler::Now();
+    const BOOL copied = CopyFileExW(src.c_str(), dst.c_str(), CopyProgressRoutine, &context, &cancel,
+                                    job->createNew ? COPY_FILE_FAIL_IF_EXISTS : 0);
+    Profiler::RecordSince(ProfileStage::SystemCopy, copyStart, copied ? fileSize : 0);
+    if (copied) {
+        if (!sourceDigest) return true;
+        auto onBlock = [&job](uint64_t) {
+            WaitWhilePaused(*job);
+            return true;
+        };
+        return ChunkedDigest::HashFile(src, *sourceDigest, m_hashPool.get(), false, onBlock);
+    }
+
+    DWORD error = GetLastError();
+    context.Rollback();
+    SetLastError(error);
+    return false;
+}
+
+/**
+ * @brief Brings one file of a Sync job up to date.
+ * * The target is left alone when it has the source's size and either (Metadata) a
+ * last-write time within kSyncTimeTolerance or (Checksum) the same content hash. Otherwise
+ * it is brought up to date: targets of at least the delta threshold only get their changed
+ * blocks rewritten (falling back to a full copy if that fails), smaller ones are overwritten.
+ * Every engine carries the source timestamp over, so the next run sees the pair as unchanged.
+ * Read-only and hidden targets would make both engines fail with ERROR_ACCESS_DENIED, so
+ * those attributes are cleared first.
+ * * @param job The owning job (skip counters, progress, pause state).
+ * @param src Source file.
+ * @param dst Target file.
+ * @param source Metadata of the source file.
+ * @param target Metadata of the existing target, or nullptr if it does not exist yet.
+ * @return true if the file was up to date or has been copied.
+ */
+bool TransferManager::SyncFile(const std::shared_ptr<FileJob>& job, const std::filesystem::path& src,
+                               const std::filesystem::path& dst, const ManifestEntry& source, const ManifestEntry* target) {
+    if (target && !target->isDirectory && target->size == source.size) {
+        bool unchanged;
+        if (job->syncCompare == SyncCompare::Checksum) {
+            unchanged = HaveSameContent(*job, src, dst, m_hashPool.get());
         } else {
-            currentJob->status = JobStatus::Failed;
-            if (currentJob->errorMessage.empty()) {
-                currentJob->errorMessage = "Win32 Error Code: " + std::to_string(GetLastError());
-            }
-            ButlerLogger::Log(LogLevel::ERR, opName + " FAILED: " + currentJob->errorMessage);
+            uint64_t delta = (source.lastWriteTime > target->lastWriteTime) ? source.lastWriteTime - target->lastWriteTime
+                                                                            : target->lastWriteTime - source.lastWriteTime;
+            unchanged = delta <= kSyncTimeTolerance;
+        }
+        if (unchanged) {
+            job->filesSkipped++;
+            job->bytesSkipped += source.size;
+            return true;
         }
     }
-}
\ No newline at end of file
+
+    constexpr DWORD kBlockingAttributes = FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_HIDDEN;
+    if (target && (target->attributes & kBlockingAttributes)) {
+        DWORD attributes = target->attributes & ~kBlockingAttributes;
+        SetFileAttributesW(dst.c_str(), attributes ? attributes : FILE_ATTRIBUTE_NORMAL);
+    }
+    if (target && !target->isDirectory && target->size > 0 && source.size >= m_deltaThreshold) {
+        uint64_t digest = 0;
+        if (DeltaCopyFile(job, src, dst, job->verify != VerifyMode::None ? &digest : nullptr)) {
+            return job->verify == VerifyMode::None || VerifyFile(job, dst, source.relativePath, digest);
+        }
+        ButlerLogger::Log(LogLevel::WARN, "Delta update failed (Win32 Error Code: {}), rewriting in full: {}",
+                          GetLastError(), ToUtf8(dst));
+    }
+    return TransferFile(job, src, dst, source.size, source.relativePath);
+}
+
+/**
+ * @brief Runs the block delta engine for one file of a Sync job.
+ * * Checksum jobs never trust cached signatures: the destination is read back and compared.
+ * Bytes compared are credited to the job as they are processed and taken back on failure.
+ * With the default 1 MB blocks the block hashes double as the source digest; other block
+ * sizes hash the (cached) source once more.
+ * * @param job The owning job (progress, pause state and compare mode).
+ * @param src Source file.
+ * @param dst Existing target file.
+ * @param sourceDigest Receives the source digest if not null.
+ * @return true on success.
+ */
+bool TransferManager::DeltaCopyFile(const std::shared_ptr<FileJob>& job, const std::filesystem::path& src,
+                                    const std::filesystem::path& dst, uint64_t* sourceDigest) {
+    CopyProgressContext context{ job.get(), &m_globalBandwidth };
+    DeltaCopyOptions options = m_deltaOptions;
+    options.verifyTarget = options.verifyTarget || job->syncCompare == SyncCompare::Checksum;
+
+    DeltaCopyStats stats;
+    bool updated = DeltaCopyEngine::Copy(src, dst, options, [&](uint64_t done, uint64_t) {
+        context.Report(done);
+        WaitWhilePaused(*job);
+        return true;
+    }, &stats);
+
+    if (!updated) {
+        DWORD error = GetLastError();
+        context.Rollback();
+        SetLastError(error);
+        return false;
+    }
+    ButlerLogger::Log(LogLevel::INFO, "DELTA {}: {} of {} blocks rewritten ({} bytes{})", ToUtf8(dst), stats.blocksWritten,
+                      stats.blocksTotal, stats.bytesWritten, stats.usedSignature ? ", from signature" : "");
+
+    if (sourceDigest) {
+        if (stats.hasSourceDigest) *sourceDigest = stats.sourceDigest;
+        else return ChunkedDigest::HashFile(src, *sourceDigest, m_hashPool.get());
+    }
+    return true;
+}
+
+/**
+ * @brief Copies one file through CopyFileWithEngine and verifies it if the job asks to.
+ * * @param job The owning job.
+ * @param src Source file.
+ * @param dst Destination file.
+ * @param fileSize Size of the source in bytes.
+ * @param relativePath Name of the file in the job's digest records.
+ * @return true if the file was copied (and, with VerifyMode::ReadBack, matched).
+ */
+bool TransferManager::TransferFile(const std::shared_ptr<FileJob>& job, const std::filesystem::path& src,
+                                   const std::filesystem::path& dst, uint64_t fileSize, const std::filesystem::path& relativePath) {
+    const auto started = m_fileObserver ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+    bool success;
+    if (job->verify == VerifyMode::None) {
+        success = CopyFileWithEngine(job, src, dst, fileSize, relativePath);
+    } else {
+        uint64_t digest = 0;
+        success = CopyFileWithEngine(job, src, dst, fileSize, relativePath, &digest) &&
+                  VerifyFile(job, dst, relativePath, digest);
+    }
+
+    if (m_fileObserver) {
+        DWORD error = GetLastError();
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+        m_fileObserver(relativePath, fileSize, static_cast<uint64_t>(elapsed.count()), success);
+        SetLastError(error);
+    }
+    return success;
+}
+
+/**
+ * @brief Stores a digest record and checks the copy for VerifyMode::ReadBack.
+ * * The read-back bypasses the system cache (FILE_FLAG_NO_BUFFERING), so it checks what
+ * reached the device rather than the pages that were just written. A mismatching copy is
+ * deleted: it carries the source timestamp, so a later Sync would otherwise trust it.
+ * * @param job The owning job (counters and digest list).
+ * @param dst The copy to check.
+ * @param relativePath Name of the file in the digest records.
+ * @param sourceDigest Digest taken from the source during the copy.
+ * @return true if no check was requested or the copy matched.
+ */
+bool TransferManager::VerifyFile(const std::shared_ptr<FileJob>& job, const std::filesystem::path& dst,
+                                 const std::filesystem::path& relativePath, uint64_t sourceDigest) {
+    ProfileScope verifyScope(ProfileStage::Verify);
+    FileDigest record;
+    record.relativePath = relativePath;
+    record.source = sourceDigest;
+
+    bool matched = true;
+    if (job->verify == VerifyMode::ReadBack) {
+        auto onBlock = [&job](uint64_t) {
+            WaitWhilePaused(*job);
+            return true;
+        };
+        matched = ChunkedDigest::HashFile(dst, record.destination, m_hashPool.get(), true, onBlock) &&
+                  record.destination == sourceDigest;
+        record.verified = matched;
+        if (matched) {
+            job->filesVerified++;
+        } else {
+            job->verifyFailures++;
+            ButlerLogger::Log(LogLevel::ERR, "VERIFY FAILED: {}", ToUtf8(dst));
+            DeleteFileW(dst.c_str());
+            SetLastError(ERROR_CRC);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(job->digestMutex);
+    job->digests.push_back(std::move(record));
+    return matched;
+}
@@ -3,49 +3,245 @@
 #include <string>
 #include <vector>
 #include <deque>
+#include <memory>
 #include <filesystem>
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <map>
+#include <span>
+#include <functional>
+#include "StreamCopy.h"
+#include "DeltaCopy.h"
+#include "DirectoryScan.h"
+#include "JobStore.h"
+#include "../Core/TokenBucket.h"
+#include "../Core/BufferPool.h"
+
+class ThreadPool;
+class JobJournal;
+struct JournalJob;
 
 enum class JobType {
     Copy,
-    Move
+    Move,
+    Sync  // Copy into the existing target, skipping files that are already up to date
+};
+
+enum class SyncCompare {
+    Metadata, // Same size and last-write time means unchanged
+    Checksum  // Same size and same XXH64 content hash means unchanged (reads both files)
+};
+
+enum class CopyEngine {
+    Auto,       // Block clone on a same-volume ReFS/Dev Drive copy, else unbuffered streaming above
+                // the manager's size threshold and CopyFileExW below it
+    System,     // Always CopyFileExW (goes through the system cache)
+    Unbuffered, // Always the unbuffered overlapped streaming engine
+    HardLink    // Same-volume copies become hard links to the source (no data is copied); others fall back to Auto
+};
+
+enum class VerifyMode {
+    None,
+    Digest,   // Record a content digest of every file while it is copied
+    ReadBack  // Also re-read every copy around the system cache and compare the digests
+};
+
+/**
+ * @brief Content digests (ChunkedDigest) of one transferred file.
+ */
+struct FileDigest {
+    std::filesystem::path relativePath; // Relative to the job source; the file name for single-file jobs
+    uint64_t source = 0;
+    uint64_t destination = 0;           // Read-back digest (VerifyMode::ReadBack only)
+    bool verified = false;              // The read-back matched the source
+};
+
+enum class IoPriority {
+    Normal,
+    Background  // Low I/O priority (and background thread mode) so interactive work stays responsive
 };
 
 enum class JobStatus {
     Pending,
     Calculating,
     Copying,
+    Deleting, // Move cleanup: removing the emptied source folders
     Paused,
     Completed,
     Failed
 };
 
+/**
+ * @brief One queued operation. Kept small: paths and display strings live in the shared
+ * JobStore and the error text is only allocated when the job fails.
+ */
 struct FileJob {
-    std::filesystem::path source;
-    std::filesystem::path destination;
+    FileJob() = default;
+    ~FileJob(); // Hands the job's paths and display strings back to the JobStore
+
+    JobPath source;
+    JobPath destination;
     JobType type; 
+    CopyEngine engine = CopyEngine::Auto;
+    SyncCompare syncCompare = SyncCompare::Metadata;
+    VerifyMode verify = VerifyMode::None;
+    IoPriority priority = IoPriority::Normal;
+    TokenBucket bandwidth; // Per-job cap in bytes per second (0 = unlimited); may be changed while the job runs
     std::atomic<float> progress{ 0.0f };
     std::atomic<JobStatus> status{ JobStatus::Pending };
-    std::string errorMessage;
+    JobStatus resumeStatus = JobStatus::Copying; // What a paused job returns to; guarded by the queue mutex
+    std::unique_ptr<std::string> error; // Null unless the job failed (see SetError)
+
+    // Byte accounting, updated by the copy engines while data moves
+    std::atomic<uint64_t> bytesTotal{ 0 };
+    std::atomic<uint64_t> bytesTransferred{ 0 };
+    std::atomic<float> throughput{ 0.0f }; // Rolling average in bytes per second
+    std::atomic<uint64_t> lastSampleTick{ 0 };
+    std::atomic<uint64_t> lastSampleBytes{ 0 };
+
+    // Sync jobs: files found up to date and left alone. Their bytes are excluded from bytesTotal.
+    std::atomic<uint64_t> filesSkipped{ 0 };
+    std::atomic<uint64_t> bytesSkipped{ 0 };
+
+    // Folder moves: source files deleted as soon as their copy landed (and verified)
+    std::atomic<uint64_t> filesDeleted{ 0 };
+
+    // Verified jobs: one digest record per transferred file, guarded by digestMutex
+    std::atomic<uint64_t> filesVerified{ 0 };
+    std::atomic<uint64_t> verifyFailures{ 0 };
+    std::vector<FileDigest> digests;
+    mutable std::mutex digestMutex;
+
+    // Volumes (upper-cased root names) the job reads from and writes to.
+    // Used by the scheduler to keep jobs on the same drive serialized.
+    std::wstring sourceVolume;
+    std::wstring destVolume;
+    uint64_t sequence = 0; // Enqueue order, keeps dispatch FIFO across volume buckets; also the journal id
+
+    // Move batch: every path is renamed into destination (a folder); source is their folder
+    std::vector<std::filesystem::path> renameBatch;
+
+    // Same-volume fast paths, resolved once per run by ProcessJob from the cached VolumeInfo
+    bool sameVolume = false;
+    uint32_t cloneClusterSize = 0; // Non-zero if copies can be block clones
+    bool hardLinks = false;        // The volume supports hard links (CopyEngine::HardLink)
+
+    // Single-file jobs writing to a freshly reserved name: the engines create the target
+    // with CREATE_NEW / COPY_FILE_FAIL_IF_EXISTS so a file that appeared meanwhile is never overwritten
+    bool createNew = false;
+
+    // Progress recorded by an interrupted earlier run (jobs restored from the journal only)
+    std::shared_ptr<const JournalJob> resume;
+
+    // Display strings fixed at enqueue time (views into the JobStore), so the queue table
+    // never allocates per frame. displayTo stays valid because the resolved destination
+    // keeps the folder it was queued with.
+    const char* displayName = "";
+    const char* displayFrom = "";
+    const char* displayTo = "";
+
+    /**
+     * @brief Records why the job failed.
+     */
+    void SetError(std::string message) { error = std::make_unique<std::string>(std::move(message)); }
+    bool HasError() const { return error != nullptr; }
+    const char* GetError() const { return error ? error->c_str() : ""; }
+
+    /**
+     * @brief Adds (or, for a failed file, subtracts) transferred bytes and refreshes
+     * progress and the throughput estimate. Safe to call from several threads.
+     */
+    void AddTransferredBytes(int64_t delta);
+
+    /**
+     * @brief Estimated seconds until completion, or a negative value if unknown.
+     */
+    double GetEtaSeconds() const;
+
+    /**
+     * @brief Copy of the digest records collected so far. Safe while the job runs.
+     */
+    std::vector<FileDigest> GetDigests() const;
 };
 
 /**
- * @brief Manages the background worker thread and job queue for file operations.
+ * @brief Immutable view of the queue published for the UI.
+ * * Jobs are shared with the manager: their status and progress fields are atomics and
+ * can be read live. Only the list itself is frozen at the given version.
+ */
+struct QueueSnapshot {
+    uint64_t version = 0;
+    std::vector<std::shared_ptr<FileJob>> jobs;
+};
+
+/**
+ * @brief Manages the background worker pool and job queue for file operations.
+ * * Jobs touching disjoint volumes run concurrently; jobs sharing a source or
+ * destination volume are serialized so a single spindle is never thrashed.
  */
 class TransferManager {
 public:
-    TransferManager();
+    /**
+     * @brief Spawns the worker pool.
+     * @param workerCount Number of worker threads. 0 picks a default based on the CPU count.
+     */
+    explicit TransferManager(unsigned int workerCount = 0);
     ~TransferManager();
 
     /**
      * @brief Adds a new file operation to the queue.
      * @param src The source file or directory path.
-     * @param dest The destination folder. The filename is automatically appended and de-duplicated.
-     * @param type The operation type (Copy or Move).
+     * @param dest The destination folder. The filename is automatically appended and de-duplicated
+     * (Sync jobs merge into an existing target instead).
+     * @param type The operation type (Copy, Move or Sync).
+     * @param engine The copy engine to use for the job's files.
+     * @param compare How Sync jobs decide that a file is unchanged.
+     * @param verify Whether copied files get digests and a read-back check.
+     * @param priority I/O priority of the job's reads and writes.
+     * @param bandwidthLimit Cap on the job's transfer rate in bytes per second (0 = unlimited).
+     */
+    void QueueJob(const std::filesystem::path& src, const std::filesystem::path& dest, JobType type,
+                  CopyEngine engine = CopyEngine::Auto, SyncCompare compare = SyncCompare::Metadata,
+                  VerifyMode verify = VerifyMode::None, IoPriority priority = IoPriority::Normal,
+                  uint64_t bandwidthLimit = 0);
+
+    /**
+     * @brief Adds one job per source, all with the same destination and options.
+     * * The destination is checked once and every job is queued under a single lock, with
+     * the paths interned in the JobStore, so large selections queue quickly.
+     * @param sources The source files or directories.
+     * @param dest The destination (see QueueJob).
      */
-    void QueueJob(const std::filesystem::path& src, const std::filesystem::path& dest, JobType type);
+    void QueueJobs(std::span<const std::filesystem::path> sources, const std::filesystem::path& dest, JobType type,
+                   CopyEngine engine = CopyEngine::Auto, SyncCompare compare = SyncCompare::Metadata,
+                   VerifyMode verify = VerifyMode::None, IoPriority priority = IoPriority::Normal,
+                   uint64_t bandwidthLimit = 0);
+
+    /**
+     * @brief Queues moves of several items into one folder.
+     * * Items on the destination's volume are collected into a single job that renames
+     * them one after the other, which costs one metadata update each. Items on other
+     * volumes are queued as regular Move jobs.
+     * @param sources The files and folders to move.
+     * @param destDir The destination folder.
+     * @param verify Verify mode of the cross-volume moves (renames move no data).
+     * @param priority I/O priority of the jobs.
+     * @param bandwidthLimit Cap on each cross-volume job's rate in bytes per second (0 = unlimited).
+     */
+    void QueueMoves(const std::vector<std::filesystem::path>& sources, const std::filesystem::path& destDir,
+                    VerifyMode verify = VerifyMode::None, IoPriority priority = IoPriority::Normal,
+                    uint64_t bandwidthLimit = 0);
+
+    /**
+     * @brief Persists the queue in a journal and restores the jobs an earlier run left unfinished.
+     * * Restored jobs are queued as pending. Folder jobs skip the files that already landed
+     * and large files continue at their last checkpoint. Call once, before queueing anything.
+     * @param path Journal file.
+     * @return Number of jobs restored.
+     */
+    size_t EnableJournal(const std::filesystem::path& path);
 
     /**
      * @brief Starts processing the queue if the worker is currently idle.
@@ -53,7 +249,7 @@ public:
     void StartQueue();
 
     /**
-     * @brief Pauses all currently running jobs.
+     * @brief Pauses all currently running jobs. Pending jobs are not started until ResumeQueue().
      */
     void PauseQueue(); 
 
@@ -67,23 +263,233 @@ public:
      * @param index The index of the job in the queue.
      */
     void RemoveJob(int index);
+
+    /**
+     * @brief Sets how many small files of a folder job are copied concurrently.
+     * @param count Number of parallel per-file copies (1 = sequential).
+     */
+    void SetFolderCopyConcurrency(unsigned int count) { m_folderCopyConcurrency = count > 0 ? count : 1; }
+    unsigned int GetFolderCopyConcurrency() const { return m_folderCopyConcurrency; }
+
+    /**
+     * @brief Sets the file size above which CopyEngine::Auto jobs use the unbuffered engine.
+     */
+    void SetUnbufferedThreshold(uint64_t bytes) { m_unbufferedThreshold = bytes; }
+    uint64_t GetUnbufferedThreshold() const { return m_unbufferedThreshold; }
+
+    /**
+     * @brief Sets block size and pipeline depth of the unbuffered engine. Call while the queue is idle.
+     */
+    void SetStreamCopyOptions(const StreamCopyOptions& options) { m_streamOptions = options; }
+
+    /**
+     * @brief Sets the file size from which Sync jobs update changed files block by block
+     * instead of rewriting them.
+     */
+    void SetDeltaThreshold(uint64_t bytes) { m_deltaThreshold = bytes; }
+    uint64_t GetDeltaThreshold() const { return m_deltaThreshold; }
+
+    /**
+     * @brief Sets block size and signature cache of the delta engine. Call while the queue is idle.
+     */
+    void SetDeltaCopyOptions(const DeltaCopyOptions& options) { m_deltaOptions = options; }
+
+    /**
+     * @brief Sets the ceiling on memory held by transfer buffers (the shared BufferPool).
+     * Transfers that would exceed it wait for buffers of other jobs. Applies immediately.
+     */
+    void SetBufferMemoryLimit(size_t bytes) { BufferPool::Shared().SetMemoryLimit(bytes); }
+    size_t GetBufferMemoryLimit() const { return BufferPool::Shared().GetMemoryLimit(); }
+
+    /**
+     * @brief Caps the combined rate of all running jobs, on top of each job's own cap.
+     * @param bytesPerSecond Limit in bytes per second, 0 for unlimited. Applies immediately.
+     */
+    void SetGlobalBandwidthLimit(uint64_t bytesPerSecond) { m_globalBandwidth.SetRate(bytesPerSecond); }
+    uint64_t GetGlobalBandwidthLimit() const { return m_globalBandwidth.GetRate(); }
+
+    /**
+     * @brief Invoked after every file a job copies with (relativePath, bytes, nanoseconds, success).
+     * Runs on the copying thread, possibly several at once. Files a sync skips are not reported.
+     */
+    using FileObserver = std::function<void(const std::filesystem::path&, uint64_t, uint64_t, bool)>;
+
+    /**
+     * @brief Installs a per-file observer (benchmarks, diagnostics). Set it before StartQueue().
+     */
+    void SetFileObserver(FileObserver observer) { m_fileObserver = std::move(observer); }
+
+    /**
+     * @brief Invoked whenever the queue changes state: a job is queued, removed, starts or
+     * finishes, or the queue is started, paused or resumed. Progress updates do not fire it.
+     * Runs on whichever thread made the change, often while the queue lock is held, so it
+     * must be quick and must not call back into the manager (e.g. glfwPostEmptyEvent).
+     */
+    using StateObserver = void (*)();
+
+    /**
+     * @brief Installs (or, with nullptr, clears) the state observer. Safe to call at any time.
+     */
+    void SetStateObserver(StateObserver observer) { m_stateObserver = observer; }
     
-    const std::deque<std::shared_ptr<FileJob>>& GetQueue() const { return m_queue; }
+    /**
+     * @brief Returns the latest snapshot of the queue.
+     * * Lock-free and copy-free while the queue structure is unchanged. After an enqueue
+     * or removal the next call republishes the snapshot once, so a burst of changes costs
+     * a single rebuild instead of one per frame.
+     */
+    std::shared_ptr<const QueueSnapshot> GetSnapshot() const;
+    /**
+     * @brief Total number of jobs that completed successfully since startup.
+     * Monotonic: removing finished jobs from the queue does not decrease it.
+     */
+    uint64_t GetCompletedCount() const { return m_completedCount; }
+    uint64_t GetFailedCount() const { return m_failedCount; }
+
     bool IsRunning() const { return m_running; }
     bool IsPaused() const { return m_paused; }
+    unsigned int GetWorkerCount() const { return static_cast<unsigned int>(m_workers.size()); }
 
 private:
     /**
-     * @brief Main background loop that processes jobs sequentially.
+     * @brief Background loop run by every worker; claims and executes jobs until shutdown.
      */
     void WorkerLoop(); 
+
+    /**
+     * @brief Fills in the derived fields of a job and appends it to the pending queue.
+     * The job's sequence must already be set. Must be called with m_queueMutex held.
+     */
+    void EnqueueLocked(const std::shared_ptr<FileJob>& job);
+
+    /**
+     * @brief Picks the oldest pending job whose volumes are idle and marks it as active.
+     * Must be called with m_queueMutex held.
+     */
+    std::shared_ptr<FileJob> ClaimNextJob();
+
+    /**
+     * @brief Releases the volumes held by a finished job and retires it from the active set.
+     * Must be called with m_queueMutex held.
+     */
+    void ReleaseJob(const std::shared_ptr<FileJob>& job);
+
+    /**
+     * @brief Calls the state observer, if one is installed.
+     */
+    void NotifyStateChanged() const;
+
+    /**
+     * @brief Executes a single job (rename, single file or recursive folder transfer).
+     */
+    void ProcessJob(const std::shared_ptr<FileJob>& currentJob);
+
+    /**
+     * @brief Removes the source folders of a folder move, deepest level first.
+     * Folders of one level are removed in parallel on pool (if not null); progress counts folders.
+     * @param directories Depth and path of every source folder below the job root.
+     * @return false if a folder (or the root) could not be removed.
+     */
+    bool RemoveSourceFolders(const std::shared_ptr<FileJob>& job,
+                             std::vector<std::pair<size_t, std::filesystem::path>>& directories, ThreadPool* pool);
+
+    /**
+     * @brief Renames every item of a Move batch into the destination folder.
+     * @return false if any item could not be moved (the job error says how many).
+     */
+    bool RenameBatch(const std::shared_ptr<FileJob>& job, const std::filesystem::path& destDir);
+
+    /**
+     * @brief Tries the same-volume fast paths for one file: a hard link (CopyEngine::HardLink)
+     * or a block clone. Progress is reported in full when one of them succeeds.
+     * @return true if the file was linked or cloned; false to copy it normally.
+     */
+    bool TryFastCopy(const std::shared_ptr<FileJob>& job, const std::filesystem::path& src,
+                     const std::filesystem::path& dst, uint64_t fileSize);
+
+    /**
+     * @brief Copies one file with the engine selected for the job, falling back to
+     * CopyFileExW if the unbuffered engine cannot handle the volume. Transferred bytes
+     * are reported to the job as they are written. Unbuffered copies of journaled jobs are
+     * checkpointed and resumed from their last checkpoint.
+     * @param relativePath Name of the file within the job (journal key).
+     * @param sourceDigest If not null, receives the ChunkedDigest of the copied data.
+     * @return true on success; otherwise GetLastError() describes the failure.
+     */
+    bool CopyFileWithEngine(const std::shared_ptr<FileJob>& job, const std::filesystem::path& src,
+                            const std::filesystem::path& dst, uint64_t fileSize, const std::filesystem::path& relativePath,
+                            uint64_t* sourceDigest = nullptr);
+
+    /**
+     * @brief Copies one file and applies the job's verify mode.
+     * @param relativePath Name recorded in the job's digest list.
+     * @return false if the copy or its verification failed.
+     */
+    bool TransferFile(const std::shared_ptr<FileJob>& job, const std::filesystem::path& src,
+                      const std::filesystem::path& dst, uint64_t fileSize, const std::filesystem::path& relativePath);
+
+    /**
+     * @brief Records a file's digest and, for VerifyMode::ReadBack, compares a read-back of
+     * the copy against it. A copy that does not match is deleted.
+     * @return false on a mismatch or read error.
+     */
+    bool VerifyFile(const std::shared_ptr<FileJob>& job, const std::filesystem::path& dst,
+                    const std::filesystem::path& relativePath, uint64_t sourceDigest);
+
+    /**
+     * @brief Updates an existing target in place with the delta engine.
+     * Progress is reported as source bytes compared.
+     * @param sourceDigest If not null, receives the ChunkedDigest of the source.
+     * @return true on success; otherwise GetLastError() describes the failure.
+     */
+    bool DeltaCopyFile(const std::shared_ptr<FileJob>& job, const std::filesystem::path& src,
+                       const std::filesystem::path& dst, uint64_t* sourceDigest = nullptr);
+
+    /**
+     * @brief Copies one file of a Sync job unless the existing target is already up to date.
+     * @param source Metadata of the source; its relativePath names the file in digest records.
+     * @param target Metadata of the existing target, or nullptr if there is none.
+     * @return true if the file was skipped or copied successfully.
+     */
+    bool SyncFile(const std::shared_ptr<FileJob>& job, const std::filesystem::path& src,
+                  const std::filesystem::path& dst, const ManifestEntry& source, const ManifestEntry* target);
     
+    using VolumePair = std::pair<std::wstring, std::wstring>;
+
+    // Every job in display order (pending, active and finished)
     std::deque<std::shared_ptr<FileJob>> m_queue;
-    std::thread m_workerThread;
+    std::vector<std::thread> m_workers;
+    std::unique_ptr<ThreadPool> m_hashPool; // Shared by all jobs for digest computation
+    std::unique_ptr<JobJournal> m_journal;  // Null unless EnableJournal() succeeded
+
+    // Dispatch index (guarded by m_queueMutex). Pending jobs are bucketed by their
+    // (source, destination) volumes, so claiming a job only looks at each bucket's front.
+    std::map<VolumePair, std::deque<std::shared_ptr<FileJob>>> m_pendingByVolumes;
+    size_t m_pendingCount = 0;
+    std::vector<std::shared_ptr<FileJob>> m_activeJobs;
+    std::map<std::wstring, int> m_busyVolumes;
+    uint64_t m_nextSequence = 0;
+
+    // Published queue view (see GetSnapshot); m_queueVersion is guarded by m_queueMutex
+    mutable std::atomic<std::shared_ptr<const QueueSnapshot>> m_snapshot;
+    mutable std::atomic<bool> m_snapshotDirty{ false };
+    uint64_t m_queueVersion = 0;
+
+    std::atomic<uint64_t> m_completedCount{ 0 };
+    std::atomic<uint64_t> m_failedCount{ 0 };
     
     // Thread synchronization
     std::atomic<bool> m_running{ false };
     std::atomic<bool> m_stopThread{ false };
     std::atomic<bool> m_paused{ false };
+    std::atomic<unsigned int> m_folderCopyConcurrency{ 8 };
+    std::atomic<uint64_t> m_unbufferedThreshold{ 512ull * 1024 * 1024 };
+    StreamCopyOptions m_streamOptions;
+    std::atomic<uint64_t> m_deltaThreshold{ 64ull * 1024 * 1024 };
+    DeltaCopyOptions m_deltaOptions;
+    TokenBucket m_globalBandwidth; // Shared by every job's copies
+    FileObserver m_fileObserver;   // Empty unless SetFileObserver() was called
+    std::atomic<StateObserver> m_stateObserver{ nullptr };
     mutable std::mutex m_queueMutex;
+    std::condition_variable m_workAvailable; // Signalled on enqueue, start, resume, job completion and shutdown
 };
\ No newline at end of file
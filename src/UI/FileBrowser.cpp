@@ -1,22 +1,155 @@
 #include "FileBrowser.h"
 #include "../Core/PlatformUtils.h"
+#include "../Core/StringMatch.h"
+#include "../Core/Profiler.h"
+#include "../Core/Utf8.h"
 #include <cctype> // For toupper
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <numeric>
+#include <cwchar>
+
+// Entries are handed from the listing thread to the UI in chunks of this size.
+static constexpr size_t kListingChunk = 512;
+
+// Longest a listing waits for the directory watch to be armed (slow shares) before it starts anyway.
+static constexpr uint32_t kWatchArmTimeoutMs = 2000;
+
+// Number of recently left directories whose listings are kept for an instant return.
+static constexpr size_t kListingCacheSize = 8;
+
+// Columns of the file table, also used as sort keys.
+enum { kColumnName = 0, kColumnSize = 1, kColumnDate = 2 };
+
+// Whole-drive searches show at most this many matches.
+static constexpr size_t kMaxDriveResults = 1000;
 
 /**
- * @brief Helper function for case-insensitive string search.
- * * @param haystack The text to search within.
- * @param needle The substring to search for.
- * @return true If needle is found in haystack (case-insensitive).
- * @return false If needle is not found.
+ * @brief State shared between a FileBrowser and one background directory listing.
+ * * The listing thread is detached: a browser that navigates away simply cancels the task
+ * and drops its reference, so a slow share never blocks the UI.
  */
-static bool StringContains(const std::string& haystack, const std::string& needle) {
-    if (needle.empty()) return true;
-    auto it = std::search(
-        haystack.begin(), haystack.end(),
-        needle.begin(), needle.end(),
-        [](char ch1, char ch2) { return std::toupper(ch1) == std::toupper(ch2); }
-    );
-    return (it != haystack.end());
+struct ListingTask {
+    fs::path path;
+    DirectoryWatcher::ArmToken watchArmed; // Waited for before enumerating
+    std::atomic<bool> cancelled{ false };
+    std::mutex mutex;
+    std::vector<FileEntry> ready; // Listed but not yet picked up by the UI (guarded by mutex)
+    bool done = false;            // Guarded by mutex
+};
+
+/**
+ * @brief Sort order of the browser: Directories first, then by the sort column.
+ * * Ties (and the Name column) fall back to the path, so the order is total.
+ * * @param column One of kColumnName, kColumnSize, kColumnDate.
+ * @param descending Reverses the order within directories and within files.
+ */
+static bool EntryLess(const FileEntry& a, const FileEntry& b, int column, bool descending) {
+    if (a.isDirectory != b.isDirectory) return a.isDirectory > b.isDirectory;
+    const FileEntry& x = descending ? b : a;
+    const FileEntry& y = descending ? a : b;
+    if (column == kColumnSize && x.size != y.size) return x.size < y.size;
+    if (column == kColumnDate && x.lastWriteTime != y.lastWriteTime) return x.lastWriteTime < y.lastWriteTime;
+    return x.path < y.path;
+}
+
+/**
+ * @brief Formats a byte count for the Size column (e.g. "12.3 MB").
+ */
+static std::string FormatSize(uint64_t bytes) {
+    static const char* units[] = { "B", "KB", "MB", "GB", "TB" };
+    double value = (double)bytes;
+    int unit = 0;
+    while (value >= 1024.0 && unit < 4) { value /= 1024.0; unit++; }
+    char buffer[32];
+    if (unit == 0) snprintf(buffer, sizeof(buffer), "%llu B", (unsigned long long)bytes);
+    else snprintf(buffer, sizeof(buffer), "%.1f %s", value, units[unit]);
+    return buffer;
+}
+
+/**
+ * @brief Formats a FILETIME tick count as local "YYYY-MM-DD HH:MM" for the Modified column.
+ */
+static std::string FormatDate(uint64_t ticks) {
+    FILETIME utc, local;
+    utc.dwLowDateTime = static_cast<DWORD>(ticks);
+    utc.dwHighDateTime = static_cast<DWORD>(ticks >> 32);
+    SYSTEMTIME st;
+    if (ticks == 0 || !FileTimeToLocalFileTime(&utc, &local) || !FileTimeToSystemTime(&local, &st)) return "";
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%04u-%02u-%02u %02u:%02u", st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute);
+    return buffer;
+}
+
+/**
+ * @brief Builds a browser entry, precomputing its display, filter and column strings.
+ * * Runs on the listing and watcher threads, so rendering and sorting never stat a file.
+ */
+static FileEntry MakeEntry(const fs::path& path, bool isDirectory, uint64_t size, uint64_t lastWriteTime, uint32_t attributes) {
+    FileEntry e;
+    e.path = path;
+    e.isDirectory = isDirectory;
+    e.size = isDirectory ? 0 : size;
+    e.lastWriteTime = lastWriteTime;
+    e.attributes = attributes;
+    // Prefix directories for visual distinction
+    e.name = ToUtf8(e.path.filename());
+    e.displayString = (e.isDirectory ? "[DIR] " : "      ") + e.name;
+    if (!isDirectory) e.sizeString = FormatSize(size);
+    e.dateString = FormatDate(lastWriteTime);
+    return e;
+}
+
+/**
+ * @brief Builds a browser entry from a watcher notification.
+ */
+static FileEntry MakeEntry(const fs::path& dir, const DirectoryChange& change) {
+    return MakeEntry(dir / change.name, change.isDirectory, change.size, change.lastWriteTime, change.attributes);
+}
+
+/**
+ * @brief Body of the detached listing thread.
+ * * Enumerates the directory with FindFirstFileExW, which returns size, timestamps and
+ * attributes with each name, and publishes entries in chunks until done or cancelled.
+ * A directory that cannot be opened (e.g., access denied) simply lists as empty.
+ * It first waits for the directory watch to be armed, so every change made after the
+ * enumeration passed an entry is reported by the watcher.
+ * * @param task The shared task state; kept alive by this thread until it returns.
+ */
+static void RunListing(std::shared_ptr<ListingTask> task) {
+    task->watchArmed.Wait(kWatchArmTimeoutMs);
+    if (task->cancelled) return;
+
+    ProfileScope listingScope(ProfileStage::Listing);
+    std::vector<FileEntry> chunk;
+    auto publish = [&]() {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        for (auto& e : chunk) task->ready.push_back(std::move(e));
+        chunk.clear();
+    };
+
+    WIN32_FIND_DATAW data;
+    HANDLE find = FindFirstFileExW((task->path / L"*").c_str(), FindExInfoBasic, &data,
+        FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+    if (find != INVALID_HANDLE_VALUE) {
+        do {
+            if (task->cancelled) break;
+            if (wcscmp(data.cFileName, L".") == 0 || wcscmp(data.cFileName, L"..") == 0) continue;
+            uint64_t size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+            uint64_t written = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+            bool isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+            chunk.push_back(MakeEntry(task->path / data.cFileName, isDirectory, size, written, data.dwFileAttributes));
+            if (chunk.size() >= kListingChunk) publish();
+        } while (FindNextFileW(find, &data));
+        FindClose(find);
+    }
+    if (task->cancelled) return;
+
+    publish();
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->done = true;
 }
 
 /**
@@ -28,33 +161,313 @@ FileBrowser::FileBrowser() {
 }
 
 /**
- * @brief Refreshes the internal list of files and directories for the current path.
- * * This function clears current entries and selection, then iterates over the filesystem.
- * Entries are sorted: Directories first, then files alphabetically.
- * Exceptions (e.g., access denied) are silently caught.
+ * @brief Cancels any listing still running in the background.
+ */
+FileBrowser::~FileBrowser() {
+    if (m_listing) m_listing->cancelled = true;
+}
+
+/**
+ * @brief Starts re-listing the current path on a background thread.
+ * * Any listing still in flight is cancelled. When the path changed since the last listing,
+ * the list is cleared and entries stream in as they arrive. A refresh of the same directory
+ * keeps the old entries visible and swaps in the new list once it is complete; returning to
+ * a recently left directory does the same, starting from its cached entries.
  */
 void FileBrowser::Refresh() {
+    ProfileScope refreshScope(ProfileStage::Refresh);
+    if (m_currentPath != m_listedPath) {
+        StashListing();
+        RestoreCachedListing(); // Makes the listing below a same-directory refresh
+    }
+
+    if (m_listing) m_listing->cancelled = true;
+
+    // Start watching before listing; the listing thread waits until the watch is armed,
+    // so nothing that changes during the listing is missed
+    if (m_watcher.GetPath() != m_currentPath || m_watcher.Failed()) {
+        m_watcher.Watch(m_currentPath);
+        m_changes.clear();
+    }
+
+    m_replaceOnComplete = (m_currentPath == m_listedPath);
+    m_staging.clear();
+    if (!m_replaceOnComplete) {
+        m_entries.clear();
+        m_lastClickedIndex = -1;
+        ClearSelection();
+        m_filterDirty = true;
+        m_listedPath = m_currentPath;
+    }
+
+    m_listing = std::make_shared<ListingTask>();
+    m_listing->path = m_currentPath;
+    m_listing->watchArmed = m_watcher.GetArmToken();
+    std::thread(RunListing, m_listing).detach();
+}
+
+/**
+ * @brief Moves the complete listing being left into the LRU cache.
+ * * Partial listings are dropped instead. The watcher is not kept: an open directory
+ * handle would keep Butler's own moves and deletes from renaming or removing a parent.
+ */
+void FileBrowser::StashListing() {
+    if (m_listing || m_listedPath.empty()) return;
+
+    m_listingCache.push_front(CachedListing{ m_listedPath, std::move(m_entries) });
+    if (m_listingCache.size() > kListingCacheSize) m_listingCache.pop_back();
     m_entries.clear();
-    m_selectedIndices.clear();
+    m_changes.clear();
+}
+
+/**
+ * @brief Shows the cached listing of the current path, if there is one.
+ * * The cached entries may be stale, so Refresh() re-lists the directory right after
+ * and swaps the fresh list in once it is complete, as for a same-directory refresh.
+ */
+void FileBrowser::RestoreCachedListing() {
+    auto it = std::find_if(m_listingCache.begin(), m_listingCache.end(),
+        [&](const CachedListing& cached) { return cached.path == m_currentPath; });
+    if (it == m_listingCache.end()) return;
+
+    if (m_listing) m_listing->cancelled = true;
+    m_listing.reset();
+    m_staging.clear();
+
+    m_entries = std::move(it->entries);
+    m_listingCache.erase(it);
+    m_listedPath = m_currentPath;
     m_lastClickedIndex = -1;
+    ClearSelection();
+    SortEntries(); // The sort column may have changed since the listing was cached
+    // A deep-link target is selected by the fresh listing, which replaces these entries
+}
+
+/**
+ * @brief Picks up entries published by the listing thread. Called once per frame.
+ * * Takes the lock only to swap the ready chunk out, so the cost per frame is bounded by
+ * the number of new entries rather than the directory size.
+ */
+void FileBrowser::PollListing() {
+    if (!m_listing) return;
+
+    std::vector<FileEntry> chunk;
+    bool done = false;
+    {
+        std::lock_guard<std::mutex> lock(m_listing->mutex);
+        chunk.swap(m_listing->ready);
+        done = m_listing->done;
+    }
+
+    if (m_replaceOnComplete) {
+        for (auto& e : chunk) m_staging.push_back(std::move(e));
+        if (done) ReplaceEntries(std::move(m_staging));
+    } else if (!chunk.empty()) {
+        MergeEntries(std::move(chunk));
+    }
+
+    if (done) {
+        m_listing.reset();
+        m_staging.clear();
+        m_listedPath = m_currentPath;
+        m_pendingSelection.clear(); // The deep-linked file is gone
+    }
+}
+
+/**
+ * @brief Applies the changes reported by the directory watcher. Called once per frame.
+ * * Changes are held back while a listing is running (it may or may not have seen them)
+ * and applied on top of the finished list; every change replaces the entry by name, so
+ * applying one the listing already reflects is harmless. A burst of notifications is
+ * coalesced to the last change per name and applied in a single pass over the entries,
+ * keeping the selection of entries that survive. If the watcher lost notifications, the
+ * directory is re-listed instead.
+ */
+void FileBrowser::PollChanges() {
+    if (m_listing) return;
+    if (!m_watcher.DrainChanges(m_changes)) {
+        m_changes.clear();
+        Refresh();
+        return;
+    }
+    if (m_changes.empty()) return;
+
+    std::unordered_map<std::wstring, const DirectoryChange*> latest;
+    for (const auto& change : m_changes) latest[change.name] = &change;
 
-    try {
-        for (const auto& entry : fs::directory_iterator(m_currentPath)) {
-            FileEntry e;
-            e.path = entry.path();
-            e.isDirectory = entry.is_directory();
-            // Prefix directories for visual distinction
-            e.displayString = (e.isDirectory ? "[DIR] " : "      ") + e.path.filename().string();
-            m_entries.push_back(e);
+    // Update or drop existing entries in place, compacting the list and its selection bitset
+    size_t kept = 0;
+    int lastClicked = -1;
+    bool resort = false;
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        auto it = latest.find(m_entries[i].path.filename().wstring());
+        if (it != latest.end()) {
+            const DirectoryChange* change = it->second;
+            bool drop = (change->kind == DirectoryChange::Kind::Remove) ||
+                        (change->isDirectory != m_entries[i].isDirectory); // Re-sorted below
+            if (drop) {
+                if (m_selected[i]) m_selectedCount--;
+                continue;
+            }
+            m_entries[i] = MakeEntry(m_currentPath, *change); // Size or date changed
+            resort = true;
+            latest.erase(it);
+        }
+        if ((int)i == m_lastClickedIndex) lastClicked = (int)kept;
+        if (kept != i) {
+            m_entries[kept] = std::move(m_entries[i]);
+            m_selected[kept] = m_selected[i];
         }
-        // Sort: Directories first, then alphabetical
-        std::sort(m_entries.begin(), m_entries.end(), [](const FileEntry& a, const FileEntry& b) {
-            if (a.isDirectory != b.isDirectory) return a.isDirectory > b.isDirectory;
-            return a.path < b.path;
-        });
-    } catch (...) {
-        // Fail silently or log if needed; implies permission denied usually
+        kept++;
     }
+    m_entries.resize(kept);
+    m_selected.resize(kept);
+    m_lastClickedIndex = lastClicked;
+    m_filterDirty = true;
+    m_displayPathDirty = true;
+    if (resort && m_sortColumn != kColumnName) SortEntries();
+
+    std::vector<FileEntry> added;
+    for (const auto& [name, change] : latest) {
+        if (change->kind == DirectoryChange::Kind::Upsert) added.push_back(MakeEntry(m_currentPath, *change));
+    }
+    m_changes.clear();
+    if (!added.empty()) MergeEntries(std::move(added));
+}
+
+/**
+ * @brief Merges a chunk of unsorted entries into the sorted list.
+ * * Selection flags travel with their entries, so rows the user already selected stay
+ * selected while the rest of the directory streams in.
+ * * @param chunk Newly listed entries.
+ */
+void FileBrowser::MergeEntries(std::vector<FileEntry>&& chunk) {
+    auto less = [this](const FileEntry& a, const FileEntry& b) { return EntryLess(a, b, m_sortColumn, m_sortDescending); };
+    std::sort(chunk.begin(), chunk.end(), less);
+
+    std::vector<FileEntry> merged;
+    std::vector<bool> mergedSelected;
+    merged.reserve(m_entries.size() + chunk.size());
+    mergedSelected.reserve(m_entries.size() + chunk.size());
+
+    int lastClicked = -1;
+    size_t a = 0, b = 0;
+    while (a < m_entries.size() || b < chunk.size()) {
+        bool takeOld = (b >= chunk.size()) || (a < m_entries.size() && !less(chunk[b], m_entries[a]));
+        if (takeOld) {
+            if ((int)a == m_lastClickedIndex) lastClicked = (int)merged.size();
+            mergedSelected.push_back(m_selected[a]);
+            merged.push_back(std::move(m_entries[a++]));
+        } else {
+            mergedSelected.push_back(false);
+            merged.push_back(std::move(chunk[b++]));
+        }
+    }
+
+    m_entries.swap(merged);
+    m_selected.swap(mergedSelected);
+    m_lastClickedIndex = lastClicked;
+    m_filterDirty = true;
+    m_displayPathDirty = true;
+    ApplyPendingSelection();
+}
+
+/**
+ * @brief Replaces the whole list with a completed same-directory listing.
+ * * @param entries The complete, unsorted listing.
+ */
+void FileBrowser::ReplaceEntries(std::vector<FileEntry>&& entries) {
+    std::sort(entries.begin(), entries.end(),
+        [this](const FileEntry& a, const FileEntry& b) { return EntryLess(a, b, m_sortColumn, m_sortDescending); });
+    m_entries = std::move(entries);
+    m_lastClickedIndex = -1;
+    ClearSelection();
+    m_filterDirty = true;
+    ApplyPendingSelection();
+}
+
+/**
+ * @brief Re-sorts the entries by the current sort column, carrying selection along.
+ * * Works purely on the cached metadata; no file is touched.
+ */
+void FileBrowser::SortEntries() {
+    std::vector<int> order(m_entries.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return EntryLess(m_entries[a], m_entries[b], m_sortColumn, m_sortDescending);
+    });
+
+    std::vector<FileEntry> sorted;
+    std::vector<bool> sortedSelected;
+    sorted.reserve(m_entries.size());
+    sortedSelected.reserve(m_entries.size());
+    int lastClicked = -1;
+    for (int i : order) {
+        if (i == m_lastClickedIndex) lastClicked = (int)sorted.size();
+        sortedSelected.push_back(m_selected[i]);
+        sorted.push_back(std::move(m_entries[i]));
+    }
+
+    m_entries.swap(sorted);
+    m_selected.swap(sortedSelected);
+    m_lastClickedIndex = lastClicked;
+    m_filterDirty = true;
+}
+
+/**
+ * @brief Selects and scrolls to the deep-linked file once it has been listed.
+ */
+void FileBrowser::ApplyPendingSelection() {
+    if (m_pendingSelection.empty()) return;
+    for (int i = 0; i < (int)m_entries.size(); i++) {
+        if (m_entries[i].path == m_pendingSelection) {
+            SetSelected(i, true);
+            m_lastClickedIndex = i;
+            m_scrollToIndex = i;
+            m_pendingSelection.clear();
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Rebuilds the list of entry indices that match the search filter.
+ * * Only runs when the entries or the filter text changed; the render loop then walks
+ * this index vector instead of re-matching every entry every frame. Matching is ASCII
+ * case-insensitive (see StringMatch).
+ */
+void FileBrowser::RebuildFilter() {
+    std::string needle = StringMatch::ToLowerAscii(m_searchFilter);
+    m_filteredIndices.clear();
+    m_filteredIndices.reserve(m_entries.size());
+    for (int i = 0; i < (int)m_entries.size(); i++) {
+        if (StringMatch::ContainsFolded(m_entries[i].name, needle)) {
+            m_filteredIndices.push_back(i);
+        }
+    }
+    m_filterDirty = false;
+}
+
+/**
+ * @brief Deselects everything and resizes the selection bitset to the current entries.
+ */
+void FileBrowser::ClearSelection() {
+    m_selected.assign(m_entries.size(), false);
+    m_selectedCount = 0;
+    m_displayPathDirty = true;
+}
+
+/**
+ * @brief Sets the selection state of one entry, keeping the selected count in sync.
+ * * @param index Index into m_entries.
+ * @param selected The new state.
+ */
+void FileBrowser::SetSelected(int index, bool selected) {
+    if (index < 0 || index >= (int)m_selected.size() || m_selected[index] == selected) return;
+    m_selected[index] = selected;
+    if (selected) m_selectedCount++;
+    else m_selectedCount--;
+    m_displayPathDirty = true;
 }
 
 /**
@@ -63,10 +476,9 @@ void FileBrowser::Refresh() {
  */
 std::vector<fs::path> FileBrowser::GetSelectedPaths() const {
     std::vector<fs::path> result;
-    for (int index : m_selectedIndices) {
-        if (index >= 0 && index < m_entries.size()) {
-            result.push_back(m_entries[index].path);
-        }
+    result.reserve(m_selectedCount);
+    for (size_t i = 0; i < m_selected.size() && result.size() < m_selectedCount; i++) {
+        if (m_selected[i]) result.push_back(m_entries[i].path);
     }
     return result;
 }
@@ -78,18 +490,18 @@ std::vector<fs::path> FileBrowser::GetSelectedPaths() const {
  * * @return std::string The formatted path string.
  */
 std::string FileBrowser::GetDisplayPath() const {
-    std::string str = m_currentPath.string();
+    std::string str = ToUtf8(m_currentPath);
     
     // Normalize root path string
     if (str.length() > 3 && str.back() == '\\') str.pop_back();
 
-    if (m_selectedIndices.size() == 1) {
-        int idx = *m_selectedIndices.begin();
-        if (idx < m_entries.size()) {
+    if (m_selectedCount == 1) {
+        auto it = std::find(m_selected.begin(), m_selected.end(), true);
+        if (it != m_selected.end()) {
             if (str.back() != '\\') str += "\\";
-            str += m_entries[idx].path.filename().string();
+            str += ToUtf8(m_entries[it - m_selected.begin()].path.filename());
         }
-    } else if (m_selectedIndices.size() > 1) {
+    } else if (m_selectedCount > 1) {
         if (str.back() != '\\') str += "\\";
         str += "*"; // Indicator for multiple selection
     }
@@ -133,8 +545,15 @@ void FileBrowser::Render(const char* id, float height) {
 
     // Search Filter
     float availableWidth = ImGui::GetContentRegionAvail().x;
-    ImGui::SetNextItemWidth(availableWidth - 40.0f);
-    ImGui::InputTextWithHint("##search", "Search files...", m_searchFilter, IM_ARRAYSIZE(m_searchFilter));
+    ImGui::SetNextItemWidth(availableWidth - 90.0f);
+    if (ImGui::InputTextWithHint("##search", "Search files...", m_searchFilter, IM_ARRAYSIZE(m_searchFilter))) {
+        m_filterDirty = true;
+        m_driveResultsDirty = true;
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Checkbox("All", &m_driveSearch)) m_driveResultsDirty = true;
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Search the whole drive instead of this folder");
     
     ImGui::SameLine();
 
@@ -146,55 +565,171 @@ void FileBrowser::Render(const char* id, float height) {
     if (ImGui::IsItemHovered()) ImGui::SetTooltip("Locate file using Windows Explorer");
 
     // Path Display
-    ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "%s", GetDisplayPath().c_str());
+    if (m_displayPathDirty) {
+        m_displayPath = GetDisplayPath();
+        m_displayPathDirty = false;
+    }
+    ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "%s", m_displayPath.c_str());
+    if (IsLoading()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(loading...)");
+    }
 
     // --- File List ---
-    ImGui::BeginChild("Files", ImVec2(0, height), true);
-    
-    for (int i = 0; i < m_entries.size(); i++) {
-        const auto& entry = m_entries[i];
-        
-        if (!StringContains(entry.path.filename().string(), m_searchFilter)) continue;
-
-        bool isSelected = (m_selectedIndices.find(i) != m_selectedIndices.end());
-        
-        if (ImGui::Selectable(entry.displayString.c_str(), isSelected, ImGuiSelectableFlags_AllowDoubleClick)) {
-            
-            if (ImGui::GetIO().KeyCtrl) {
-                // Toggle Selection
-                if (isSelected) m_selectedIndices.erase(i);
-                else m_selectedIndices.insert(i);
-                m_lastClickedIndex = i;
-            }
-            else if (ImGui::GetIO().KeyShift && m_lastClickedIndex != -1) {
-                // Range Selection
-                m_selectedIndices.clear();
-                int start = std::min(m_lastClickedIndex, i);
-                int end = std::max(m_lastClickedIndex, i);
-                for (int k = start; k <= end; k++) m_selectedIndices.insert(k);
+    PollListing();
+    PollChanges();
+    if (m_filterDirty) RebuildFilter();
+
+    if (m_driveSearch) {
+        RenderDriveSearch(height);
+        ImGui::EndGroup();
+        ImGui::PopID();
+        return;
+    }
+
+    fs::path navigateTo; // Deferred so m_entries is not rebuilt while it is being iterated
+
+    const ImGuiTableFlags tableFlags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+                                       ImGuiTableFlags_Resizable | ImGuiTableFlags_Sortable;
+    if (ImGui::BeginTable("Files", 3, tableFlags, ImVec2(0, height))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch | ImGuiTableColumnFlags_DefaultSort);
+        ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_PreferSortDescending, 80.0f);
+        ImGui::TableSetupColumn("Modified", ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_PreferSortDescending, 120.0f);
+        ImGui::TableHeadersRow();
+
+        // Sorting only reorders the cached entries, so it never touches the filesystem
+        if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs()) {
+            if (specs->SpecsDirty && specs->SpecsCount > 0) {
+                m_sortColumn = specs->Specs[0].ColumnIndex;
+                m_sortDescending = (specs->Specs[0].SortDirection == ImGuiSortDirection_Descending);
+                SortEntries();
+                RebuildFilter();
             }
-            else {
-                // Single Selection
-                m_selectedIndices.clear();
-                m_selectedIndices.insert(i);
-                m_lastClickedIndex = i;
+            specs->SpecsDirty = false;
+        }
+
+        // Bring a deep-linked entry into view (rows outside the clipper are never submitted)
+        if (m_scrollToIndex >= 0) {
+            auto pos = std::find(m_filteredIndices.begin(), m_filteredIndices.end(), m_scrollToIndex);
+            if (pos != m_filteredIndices.end()) {
+                float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+                ImGui::SetScrollY((float)(pos - m_filteredIndices.begin()) * rowHeight - height * 0.5f);
             }
+            m_scrollToIndex = -1;
+        }
+
+        ImGuiListClipper clipper;
+        clipper.Begin((int)m_filteredIndices.size());
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                int i = m_filteredIndices[row];
+                const auto& entry = m_entries[i];
+                bool isSelected = m_selected[i];
+
+                ImGui::PushID(i);
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(kColumnName);
+                if (ImGui::Selectable(entry.displayString.c_str(), isSelected,
+                                      ImGuiSelectableFlags_AllowDoubleClick | ImGuiSelectableFlags_SpanAllColumns)) {
+                
+                    if (ImGui::GetIO().KeyCtrl) {
+                        // Toggle Selection
+                        SetSelected(i, !isSelected);
+                        m_lastClickedIndex = i;
+                    }
+                    else if (ImGui::GetIO().KeyShift && m_lastClickedIndex != -1) {
+                        // Range Selection (over the visible, filtered rows)
+                        ClearSelection();
+                        auto anchor = std::find(m_filteredIndices.begin(), m_filteredIndices.end(), m_lastClickedIndex);
+                        int anchorRow = (anchor != m_filteredIndices.end()) ? (int)(anchor - m_filteredIndices.begin()) : row;
+                        int start = std::min(anchorRow, row);
+                        int end = std::max(anchorRow, row);
+                        for (int k = start; k <= end; k++) SetSelected(m_filteredIndices[k], true);
+                    }
+                    else {
+                        // Single Selection
+                        ClearSelection();
+                        SetSelected(i, true);
+                        m_lastClickedIndex = i;
+                    }
 
-            if (ImGui::IsMouseDoubleClicked(0) && entry.isDirectory) {
-                m_currentPath = entry.path;
-                memset(m_searchFilter, 0, sizeof(m_searchFilter));
-                Refresh();
+                    if (ImGui::IsMouseDoubleClicked(0) && entry.isDirectory) navigateTo = entry.path;
+                }
+                ImGui::TableSetColumnIndex(kColumnSize);
+                ImGui::TextUnformatted(entry.sizeString.c_str());
+                ImGui::TableSetColumnIndex(kColumnDate);
+                ImGui::TextUnformatted(entry.dateString.c_str());
+                ImGui::PopID();
             }
         }
-        
-        if (isSelected && ImGui::IsWindowAppearing()) ImGui::SetScrollHereY();
+        ImGui::EndTable();
+    }
+
+    if (!navigateTo.empty()) {
+        m_currentPath = navigateTo;
+        memset(m_searchFilter, 0, sizeof(m_searchFilter));
+        Refresh();
     }
-    ImGui::EndChild();
 
     ImGui::EndGroup();
     ImGui::PopID();
 }
 
+/**
+ * @brief Renders the results of a whole-drive search in place of the file list.
+ * * The index of the current drive is built in the background on first use; queries run
+ * only when the search text changes. Double-clicking a result opens its folder with the
+ * result selected.
+ * * @param height The height of the results area.
+ */
+void FileBrowser::RenderDriveSearch(float height) {
+    if (!m_driveIndex || m_driveIndex->GetDrive() != toupper(m_currentDrive)) {
+        m_driveIndex = DriveIndex::Acquire(m_currentDrive);
+        m_driveResultsDirty = true;
+    }
+    if (m_driveResultsDirty && m_driveIndex->IsReady()) {
+        m_driveResults = m_driveIndex->Search(m_searchFilter, kMaxDriveResults);
+        m_driveResultStrings.clear();
+        m_driveResultStrings.reserve(m_driveResults.size());
+        for (const auto& path : m_driveResults) m_driveResultStrings.push_back(ToUtf8(path));
+        m_driveResultsDirty = false;
+    }
+
+    fs::path navigateTo;
+    ImGui::BeginChild("DriveResults", ImVec2(0, height), true);
+    if (!m_driveIndex->IsReady()) {
+        ImGui::TextDisabled("Indexing %c: ... %llu entries", m_driveIndex->GetDrive(),
+                            (unsigned long long)m_driveIndex->GetIndexedCount());
+    } else if (m_searchFilter[0] == '\0') {
+        ImGui::TextDisabled("Type to search all of %c:", m_driveIndex->GetDrive());
+    } else if (m_driveResults.empty()) {
+        ImGui::TextDisabled("No matches");
+    } else {
+        if (m_driveResults.size() >= kMaxDriveResults) {
+            ImGui::TextDisabled("Showing the first %d matches", (int)kMaxDriveResults);
+        }
+        ImGuiListClipper clipper;
+        clipper.Begin((int)m_driveResults.size());
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                ImGui::PushID(row);
+                if (ImGui::Selectable(m_driveResultStrings[row].c_str(), false, ImGuiSelectableFlags_AllowDoubleClick) &&
+                    ImGui::IsMouseDoubleClicked(0)) {
+                    navigateTo = m_driveResults[row];
+                }
+                ImGui::PopID();
+            }
+        }
+    }
+    ImGui::EndChild();
+
+    if (!navigateTo.empty()) {
+        m_driveSearch = false;
+        NavigateToFile(navigateTo);
+    }
+}
+
 /**
  * @brief Navigates to the parent directory of the current path.
  */
@@ -225,18 +760,12 @@ void FileBrowser::NavigateToFile(const fs::path& targetFile) {
     if (!fs::exists(targetFile)) return;
     
     m_currentPath = targetFile.parent_path();
-    std::string pathStr = m_currentPath.string();
-    if (pathStr.length() >= 2 && pathStr[1] == ':') m_currentDrive = toupper(pathStr[0]);
-    
-    Refresh();
+    const std::wstring pathStr = m_currentPath.wstring();
+    if (pathStr.length() >= 2 && pathStr[1] == L':' && pathStr[0] < 0x80) m_currentDrive = toupper(static_cast<char>(pathStr[0]));
     
-    // Select the file and clear filters so it is visible
+    // Select the file (once the listing reaches it) and clear filters so it is visible
     memset(m_searchFilter, 0, sizeof(m_searchFilter));
-    for (int i = 0; i < m_entries.size(); i++) {
-        if (m_entries[i].path == targetFile) {
-            m_selectedIndices.insert(i);
-            m_lastClickedIndex = i;
-            break;
-        }
-    }
+    m_filterDirty = true;
+    m_pendingSelection = targetFile;
+    Refresh();
 }
\ No newline at end of file
@@ -3,10 +3,14 @@
 #include <string>
 #include <vector>
 #include <filesystem>
-#include <set>
 #include <algorithm>
+#include <memory>
+#include <list>
+#include <cstdint>
 #include <windows.h>
 #include "imgui.h"
+#include "../Core/DirectoryWatcher.h"
+#include "../Core/DriveIndex.h"
 
 namespace fs = std::filesystem;
 
@@ -16,9 +20,26 @@ namespace fs = std::filesystem;
 struct FileEntry {
     fs::path path;
     bool isDirectory;
+    uint64_t size = 0;          // Bytes (0 for directories)
+    uint64_t lastWriteTime = 0; // FILETIME as 100 ns ticks since 1601
+    uint32_t attributes = 0;    // FILE_ATTRIBUTE_* flags
     std::string displayString;
+    std::string name;           // UTF-8 file name, matched by the search filter
+    std::string sizeString;     // Preformatted column text
+    std::string dateString;
 };
 
+/**
+ * @brief A listing kept after navigating away. Shown at once on return while the
+ * directory is re-listed in the background; no handle to the directory is kept open.
+ */
+struct CachedListing {
+    fs::path path;
+    std::vector<FileEntry> entries;
+};
+
+struct ListingTask;
+
 /**
  * @brief A self-contained File Browser component.
  * * Handles filesystem navigation, drive selection, file filtering, 
@@ -27,6 +48,7 @@ struct FileEntry {
 class FileBrowser {
 public:
     FileBrowser();
+    ~FileBrowser();
 
     /**
      * @brief Renders the File Browser UI.
@@ -38,14 +60,36 @@ public:
     /**
      * @brief Refreshes the file list for the current directory.
      * Should be called when an external operation modifies the filesystem.
+     * * The listing runs on a background thread and never blocks the caller. After
+     * navigating, entries stream in as they are found; a refresh of the same directory
+     * keeps the current list on screen until the new one is complete.
+     * * Navigating to one of the recently left directories shows its cached listing
+     * instantly, then re-reads the directory in the background and replaces the list
+     * once the fresh one is complete.
      */
     void Refresh();
 
+    /**
+     * @brief Returns true while a background listing is in progress.
+     */
+    bool IsLoading() const { return m_listing != nullptr; }
+
+    /**
+     * @brief Returns true if changes to the current directory are picked up automatically.
+     * When false, the owner should call Refresh() after modifying the directory.
+     */
+    bool IsWatching() const { return !m_watcher.Failed(); }
+
     /**
      * @brief Returns a list of all currently selected file paths.
      */
     std::vector<fs::path> GetSelectedPaths() const;
 
+    /**
+     * @brief Returns true if at least one entry is selected. O(1), safe to call every frame.
+     */
+    bool HasSelection() const { return m_selectedCount > 0; }
+
     /**
      * @brief Returns the directory currently currently open in the browser.
      */
@@ -57,12 +101,53 @@ private:
     void NavigateToFile(const fs::path& targetFile);
     void ChangeDrive(char driveLetter);
     std::string GetDisplayPath() const;
+    void RebuildFilter();
+    void ClearSelection();
+    void SetSelected(int index, bool selected);
+    void PollListing();
+    void MergeEntries(std::vector<FileEntry>&& chunk);
+    void ReplaceEntries(std::vector<FileEntry>&& entries);
+    void ApplyPendingSelection();
+    void PollChanges();
+    void SortEntries();
+    void StashListing();
+    void RestoreCachedListing();
+    void RenderDriveSearch(float height);
 
     // Internal State
     fs::path m_currentPath;
     std::vector<FileEntry> m_entries;
-    std::set<int> m_selectedIndices;
+    std::vector<int> m_filteredIndices;  // Indices into m_entries that pass the search filter
+    bool m_filterDirty = true;           // Set when m_entries or m_searchFilter change
+    std::vector<bool> m_selected;        // Selection bitset, parallel to m_entries
+    size_t m_selectedCount = 0;
+    std::string m_displayPath;           // Cached header text, rebuilt when path or selection changes
+    bool m_displayPathDirty = true;
+    int m_scrollToIndex = -1;            // Entry to bring into view on the next frame
     int m_lastClickedIndex = -1;
+
+    // Background listing (see Refresh)
+    std::shared_ptr<ListingTask> m_listing;
+    std::vector<FileEntry> m_staging;    // Same-directory refresh: collected until complete
+    bool m_replaceOnComplete = false;
+    fs::path m_listedPath;               // Directory m_entries currently belongs to
+    fs::path m_pendingSelection;         // File to select once it shows up in the listing
+
+    // Change notifications for m_currentPath, applied at most once per frame
+    DirectoryWatcher m_watcher;
+    std::vector<DirectoryChange> m_changes;
+
+    std::list<CachedListing> m_listingCache; // Recently left directories, most recent first
+    int m_sortColumn = 0;                    // Column index of the file table (Name, Size, Modified)
+    bool m_sortDescending = false;
+
+    // Whole-drive search: the search box queries a shared index of the current drive
+    bool m_driveSearch = false;
+    std::shared_ptr<DriveIndex> m_driveIndex;
+    std::vector<fs::path> m_driveResults;
+    std::vector<std::string> m_driveResultStrings;
+    bool m_driveResultsDirty = false;
+
     char m_currentDrive = 'C';
     char m_searchFilter[256] = ""; 
 };
\ No newline at end of file
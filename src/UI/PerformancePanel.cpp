@@ -0,0 +1,137 @@
+#include "PerformancePanel.h"
+#include <algorithm>
+#include <cstdio>
+
+// Stage rates are recomputed this often.
+static constexpr uint64_t kSampleIntervalNs = 500ull * 1000 * 1000;
+
+// Where "Save trace" writes the Chrome trace (open it in chrome://tracing or Perfetto).
+static const char* kTracePath = "logs/butler-trace.json";
+
+/**
+ * @brief Formats a duration in the most readable unit ("850 ns", "12.4 us", "3.2 ms", "1.5 s").
+ */
+static void FormatDuration(double ns, char* out, size_t size) {
+    if (ns < 1000.0) snprintf(out, size, "%.0f ns", ns);
+    else if (ns < 1000.0 * 1000) snprintf(out, size, "%.1f us", ns / 1000.0);
+    else if (ns < 1000.0 * 1000 * 1000) snprintf(out, size, "%.1f ms", ns / (1000.0 * 1000));
+    else snprintf(out, size, "%.2f s", ns / (1000.0 * 1000 * 1000));
+}
+
+void PerformancePanel::AddFrame(uint64_t cpuNs, uint64_t intervalNs) {
+    m_cpuMs[m_frameCursor] = static_cast<float>(cpuNs / 1e6);
+    m_frameMs[m_frameCursor] = static_cast<float>(intervalNs / 1e6);
+    m_frameCursor = (m_frameCursor + 1) % kFrameHistory;
+}
+
+/**
+ * @brief Takes a profiler snapshot once per interval and keeps the change since the previous one.
+ */
+void PerformancePanel::Sample() {
+    const uint64_t now = Profiler::Now();
+    if (m_lastSampleNs != 0 && now - m_lastSampleNs < kSampleIntervalNs) return;
+
+    ProfileSnapshot totals;
+    Profiler::Snapshot(totals);
+    for (size_t s = 0; s < kProfileStageCount; s++) {
+        ProfileStageStats& delta = m_window[s];
+        delta.count = totals[s].count - m_totals[s].count;
+        delta.totalNs = totals[s].totalNs - m_totals[s].totalNs;
+        delta.bytes = totals[s].bytes - m_totals[s].bytes;
+        delta.maxNs = totals[s].maxNs;
+        for (size_t b = 0; b < kProfileBuckets; b++) delta.histogram[b] = totals[s].histogram[b] - m_totals[s].histogram[b];
+    }
+    m_windowSeconds = m_lastSampleNs != 0 ? (now - m_lastSampleNs) / 1e9 : 0.0;
+    m_totals = totals;
+    m_lastSampleNs = now;
+}
+
+/**
+ * @brief Draws frame times, the stage table, the selected stage's histogram and trace controls.
+ */
+void PerformancePanel::Render(bool* open) {
+    Sample();
+
+    ImGui::SetNextWindowSize(ImVec2(560, 520), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Performance", open)) {
+        ImGui::End();
+        return;
+    }
+
+    // Frame times (oldest on the left)
+    float frameMax = 0.0f, frameSum = 0.0f, cpuSum = 0.0f;
+    for (int i = 0; i < kFrameHistory; i++) {
+        frameMax = std::max(frameMax, m_frameMs[i]);
+        frameSum += m_frameMs[i];
+        cpuSum += m_cpuMs[i];
+    }
+    char overlay[96];
+    snprintf(overlay, sizeof(overlay), "frame %.2f ms avg, %.2f ms max | cpu %.2f ms avg",
+             frameSum / kFrameHistory, frameMax, cpuSum / kFrameHistory);
+    ImGui::PlotLines("##FrameTimes", m_frameMs, kFrameHistory, m_frameCursor, overlay, 0.0f,
+                     std::max(frameMax, 33.4f), ImVec2(-1, 70));
+    ImGui::PlotLines("##CpuTimes", m_cpuMs, kFrameHistory, m_frameCursor, "cpu", 0.0f,
+                     std::max(frameMax, 33.4f), ImVec2(-1, 40));
+
+    ImGui::Separator();
+    if (ImGui::BeginTable("Stages", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV)) {
+        ImGui::TableSetupColumn("Stage");
+        ImGui::TableSetupColumn("Per second");
+        ImGui::TableSetupColumn("Average");
+        ImGui::TableSetupColumn("Max (ever)");
+        ImGui::TableSetupColumn("MB/s");
+        ImGui::TableHeadersRow();
+
+        const double seconds = m_windowSeconds > 0.0 ? m_windowSeconds : 1.0;
+        for (size_t s = 0; s < kProfileStageCount; s++) {
+            const ProfileStageStats& stats = m_window[s];
+            char average[32] = "-", maximum[32] = "-";
+            if (stats.count > 0) FormatDuration(static_cast<double>(stats.totalNs) / stats.count, average, sizeof(average));
+            if (stats.maxNs > 0) FormatDuration(static_cast<double>(stats.maxNs), maximum, sizeof(maximum));
+
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            if (ImGui::Selectable(Profiler::GetStageName(static_cast<ProfileStage>(s)), m_selectedStage == static_cast<int>(s),
+                                  ImGuiSelectableFlags_SpanAllColumns)) {
+                m_selectedStage = static_cast<int>(s);
+            }
+            ImGui::TableSetColumnIndex(1); ImGui::Text("%.0f", stats.count / seconds);
+            ImGui::TableSetColumnIndex(2); ImGui::TextUnformatted(average);
+            ImGui::TableSetColumnIndex(3); ImGui::TextUnformatted(maximum);
+            ImGui::TableSetColumnIndex(4);
+            if (stats.bytes > 0) ImGui::Text("%.1f", stats.bytes / seconds / (1024.0 * 1024.0));
+            else ImGui::TextDisabled("-");
+        }
+        ImGui::EndTable();
+    }
+
+    // Latency histogram of the selected stage over the window (log2 buckets)
+    float buckets[kProfileBuckets];
+    const ProfileStageStats& selected = m_window[m_selectedStage];
+    float bucketMax = 0.0f;
+    for (size_t b = 0; b < kProfileBuckets; b++) {
+        buckets[b] = static_cast<float>(selected.histogram[b]);
+        bucketMax = std::max(bucketMax, buckets[b]);
+    }
+    char title[64];
+    snprintf(title, sizeof(title), "%s latency", Profiler::GetStageName(static_cast<ProfileStage>(m_selectedStage)));
+    ImGui::PlotHistogram("##Histogram", buckets, static_cast<int>(kProfileBuckets), 0, title, 0.0f,
+                         std::max(bucketMax, 1.0f), ImVec2(-1, 90));
+    ImGui::TextDisabled("1 us                 1 ms                 1 s  (log2 buckets)");
+
+    ImGui::Separator();
+    if (!Profiler::IsTracing()) {
+        if (ImGui::Button("Start trace")) {
+            Profiler::StartTrace();
+            m_traceStatus = "Recording...";
+        }
+    } else if (ImGui::Button("Stop and save trace")) {
+        Profiler::StopTrace();
+        m_traceStatus = Profiler::WriteChromeTrace(kTracePath) ? std::string("Saved ") + kTracePath
+                                                               : std::string("Cannot write ") + kTracePath;
+    }
+    ImGui::SameLine();
+    ImGui::TextUnformatted(m_traceStatus.c_str());
+
+    ImGui::End();
+}
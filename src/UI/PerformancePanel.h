@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "imgui.h"
+#include "../Core/Profiler.h"
+
+/**
+ * @brief Floating window with live profiler data: frame times, per-stage rates and
+ * latency histograms, and Chrome-trace capture.
+ * * Stage figures are deltas over the last sampling window (about half a second), so
+ * they show what is happening now rather than averages since startup.
+ */
+class PerformancePanel {
+public:
+    /**
+     * @brief Adds a frame to the frame-time graph.
+     * @param cpuNs Time the frame spent on the CPU (polling to swap).
+     * @param intervalNs Time since the previous frame started.
+     */
+    void AddFrame(uint64_t cpuNs, uint64_t intervalNs);
+
+    /**
+     * @brief Draws the window. open is cleared when the user closes it.
+     */
+    void Render(bool* open);
+
+private:
+    void Sample();
+
+    static constexpr int kFrameHistory = 240;
+    float m_frameMs[kFrameHistory] = {};
+    float m_cpuMs[kFrameHistory] = {};
+    int m_frameCursor = 0;
+
+    ProfileSnapshot m_totals{};  // Totals at the last sample
+    ProfileSnapshot m_window{};  // Change over the last sampling window
+    double m_windowSeconds = 0.0;
+    uint64_t m_lastSampleNs = 0;
+
+    int m_selectedStage = static_cast<int>(ProfileStage::Write);
+    std::string m_traceStatus;
+};
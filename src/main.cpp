@@ -3,25 +3,71 @@
 #include "imgui_impl_opengl3.h"
 #include <GLFW/glfw3.h>
 #include <stdio.h>
+#include <algorithm>
+#include <atomic>
 #include <objbase.h> 
 
 #include "Jobs/TransferManager.h"
 #include "Core/Logger.h"
+#include "Core/Profiler.h"
 #include "UI/FileBrowser.h" 
+#include "UI/PerformancePanel.h"
+
+// Frame pacing. The loop draws at the display rate only while the user interacts; while
+// jobs merely advance their progress bars it draws a few frames per second, and when
+// nothing changes it sleeps until input or a queue state change wakes it.
+static constexpr double kInteractiveSeconds = 0.5;       // Full rate for this long after the last input
+static constexpr double kProgressFrameSeconds = 1.0 / 8; // Frame interval while jobs are running
+static constexpr double kIdleFrameSeconds = 1.0;         // Heartbeat that picks up directory watcher changes
+
+static double g_lastInputTime = 0.0; // glfwGetTime() of the last input event; UI thread only
+// Set while the loop sleeps for a heartbeat. Queue changes only wake it then: a burst of
+// small jobs would otherwise wake it at the display rate while it is being throttled.
+static std::atomic<bool> g_wakeOnQueueChange{ false };
+
+static void MarkInput() { g_lastInputTime = glfwGetTime(); }
+
+/**
+ * @brief Records the time of every input event the window receives.
+ * * Installed before the ImGui backend, which chains to these callbacks from its own,
+ * so ImGui still sees every event.
+ */
+static void InstallInputCallbacks(GLFWwindow* window) {
+    glfwSetCursorPosCallback(window, [](GLFWwindow*, double, double) { MarkInput(); });
+    glfwSetCursorEnterCallback(window, [](GLFWwindow*, int) { MarkInput(); });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow*, int, int, int) { MarkInput(); });
+    glfwSetScrollCallback(window, [](GLFWwindow*, double, double) { MarkInput(); });
+    glfwSetKeyCallback(window, [](GLFWwindow*, int, int, int, int) { MarkInput(); });
+    glfwSetCharCallback(window, [](GLFWwindow*, unsigned int) { MarkInput(); });
+    glfwSetWindowFocusCallback(window, [](GLFWwindow*, int) { MarkInput(); });
+    // Resizes and uncovered regions need a redraw even without input
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow*) { MarkInput(); });
+}
 
 /**
- * @brief Counts the number of jobs that have been completed.
- * * This helper function is used by the main loop to detect when a job finishes
- * so that the file browser UIs can be auto-refreshed.
- * * @param queue The deque of jobs to check.
- * @return int The count of completed jobs.
+ * @brief Formats a job's rolling throughput and ETA for the queue table.
+ * * Writes into caller-provided buffers so the per-row cost is a couple of snprintf calls.
+ * Only running jobs show a rate; everything else renders as "-".
+ * * @param job The job to describe.
+ * @param speed Receives e.g. "85.3 MB/s".
+ * @param eta Receives e.g. "1:05:12" or "42s".
  */
-int CountCompletedJobs(const std::deque<std::shared_ptr<FileJob>>& queue) {
-    int count = 0;
-    for (const auto& job : queue) {
-        if (job->status == JobStatus::Completed) count++;
+void FormatJobRate(const FileJob& job, char (&speed)[32], char (&eta)[32]) {
+    JobStatus status = job.status;
+    float rate = job.throughput;
+    if ((status != JobStatus::Copying && status != JobStatus::Paused) || rate <= 0.0f) {
+        snprintf(speed, sizeof(speed), "-");
+        snprintf(eta, sizeof(eta), "-");
+        return;
     }
-    return count;
+    snprintf(speed, sizeof(speed), "%.1f MB/s", rate / (1024.0f * 1024.0f));
+
+    double seconds = job.GetEtaSeconds();
+    if (seconds < 0) { snprintf(eta, sizeof(eta), "-"); return; }
+    long long s = (long long)seconds;
+    if (s >= 3600) snprintf(eta, sizeof(eta), "%lld:%02lld:%02lld", s / 3600, (s / 60) % 60, s % 60);
+    else if (s >= 60) snprintf(eta, sizeof(eta), "%lld:%02lld", s / 60, s % 60);
+    else snprintf(eta, sizeof(eta), "%llds", s);
 }
 
 /**
@@ -56,28 +102,51 @@ int main(int, char**)
     style.Colors[ImGuiCol_PlotHistogram] = ImVec4(0.0f, 0.7f, 0.0f, 1.0f);
     style.CellPadding = ImVec2(5.0f, 5.0f);
 
+    InstallInputCallbacks(window);
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 130");
 
     // --- SYSTEMS INITIALIZATION ---
     TransferManager transferManager;
+    transferManager.EnableJournal("cache/journal.bin"); // Restores jobs left unfinished by the last session
+    // Queue changes come from worker threads; an empty event wakes the loop to show them.
+    transferManager.SetStateObserver([] {
+        if (g_wakeOnQueueChange) glfwPostEmptyEvent();
+    });
     FileBrowser leftBrowser;
     FileBrowser rightBrowser;
     
     int selectedQueueIndex = -1; 
-    int previousCompletedCount = 0;
+    bool syncByChecksum = false; // Sync compares content hashes instead of size + timestamp
+    bool verifyCopies = false;   // Re-read every copy and compare it with the source digest
+    bool backgroundIo = false;   // Queue new jobs at low I/O priority
+    bool hardLinkCopies = false; // Same-volume copies become hard links
+    int globalLimitMb = 0;       // Global bandwidth cap in MB/s (0 = unlimited)
+    uint64_t previousCompletedCount = 0;
+    PerformancePanel performancePanel;
+    bool showPerformance = false;
+    uint64_t previousFrameStart = Profiler::Now();
+    bool lowPowerRendering = true; // Pace frames by activity instead of drawing at the display rate
+    double frameTimeout = 0.0;     // How long the next wait may sleep; 0 polls
 
     // --- MAIN LOOP ---
     while (!glfwWindowShouldClose(window))
     {
-        glfwPollEvents();
+        // A minimized window draws nothing; restoring it (or any event) ends the wait.
+        if (glfwGetWindowAttrib(window, GLFW_ICONIFIED)) {
+            glfwWaitEvents();
+            continue;
+        }
+        if (frameTimeout > 0.0) glfwWaitEventsTimeout(frameTimeout);
+        else glfwPollEvents();
+        const uint64_t frameStart = Profiler::Now();
 
-        // Check for Auto-Refresh (If a job finished, refresh file lists)
-        int currentCompletedCount = CountCompletedJobs(transferManager.GetQueue());
+        // Browsers pick up changes through their directory watchers. Only panes whose
+        // directory cannot be watched (e.g. some network filesystems) are re-listed here.
+        uint64_t currentCompletedCount = transferManager.GetCompletedCount();
         if (currentCompletedCount > previousCompletedCount) {
-            leftBrowser.Refresh();
-            rightBrowser.Refresh();
-            ButlerLogger::Log("Job finished. Refreshing file browsers.");
+            if (!leftBrowser.IsWatching()) leftBrowser.Refresh();
+            if (!rightBrowser.IsWatching()) rightBrowser.Refresh();
         }
         previousCompletedCount = currentCompletedCount;
 
@@ -112,23 +181,39 @@ int main(int, char**)
         ImGui::Separator();
         
         float width = ImGui::GetWindowWidth();
-        ImGui::SetCursorPosX((width - 300) * 0.5f);
+        ImGui::SetCursorPosX((width - 840) * 0.5f);
         
         // Batch Processing Logic
-        std::vector<fs::path> sources = leftBrowser.GetSelectedPaths();
-        bool canCopy = !sources.empty();
+        bool canCopy = leftBrowser.HasSelection();
+
+        VerifyMode verify = verifyCopies ? VerifyMode::ReadBack : VerifyMode::None;
+        IoPriority priority = backgroundIo ? IoPriority::Background : IoPriority::Normal;
 
         if (ImGui::Button("COPY >>>", ImVec2(140, 40)) && canCopy) {
-            for (const auto& src : sources) {
-                transferManager.QueueJob(src, rightBrowser.GetCurrentPath(), JobType::Copy);
-            }
+            CopyEngine engine = hardLinkCopies ? CopyEngine::HardLink : CopyEngine::Auto;
+            std::vector<std::filesystem::path> selection = leftBrowser.GetSelectedPaths();
+            transferManager.QueueJobs(selection, rightBrowser.GetCurrentPath(), JobType::Copy, engine,
+                                      SyncCompare::Metadata, verify, priority);
         }
         ImGui::SameLine();
         if (ImGui::Button("MOVE >>>", ImVec2(140, 40)) && canCopy) {
-             for (const auto& src : sources) {
-                transferManager.QueueJob(src, rightBrowser.GetCurrentPath(), JobType::Move);
-             }
+            // Same-volume items are renamed as one batch job
+            transferManager.QueueMoves(leftBrowser.GetSelectedPaths(), rightBrowser.GetCurrentPath(), verify, priority);
         }
+        ImGui::SameLine();
+        if (ImGui::Button("SYNC >>>", ImVec2(140, 40)) && canCopy) {
+            SyncCompare compare = syncByChecksum ? SyncCompare::Checksum : SyncCompare::Metadata;
+            std::vector<std::filesystem::path> selection = leftBrowser.GetSelectedPaths();
+            transferManager.QueueJobs(selection, rightBrowser.GetCurrentPath(), JobType::Sync, CopyEngine::Auto, compare, verify, priority);
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("Checksum", &syncByChecksum);
+        ImGui::SameLine();
+        ImGui::Checkbox("Verify", &verifyCopies);
+        ImGui::SameLine();
+        ImGui::Checkbox("Background", &backgroundIo);
+        ImGui::SameLine();
+        ImGui::Checkbox("Link", &hardLinkCopies);
         
         ImGui::Separator();
 
@@ -142,7 +227,9 @@ int main(int, char**)
         ImGui::Text("Active Transfer Queue");
         ImGui::Separator();
 
-        auto queue = transferManager.GetQueue();
+        // Snapshot of the job list; status/progress are atomics read live from each job
+        std::shared_ptr<const QueueSnapshot> snapshot = transferManager.GetSnapshot();
+        const auto& queue = snapshot->jobs;
 
         if (queue.empty()) {
              float winHeight = ImGui::GetWindowHeight();
@@ -151,49 +238,65 @@ int main(int, char**)
              ImGui::TextDisabled("No active jobs pending.");
         } 
         else {
-            if (ImGui::BeginTable("QueueTable", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable)) {
+            if (ImGui::BeginTable("QueueTable", 8, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable)) {
                 ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthFixed, 40.0f);
                 ImGui::TableSetupColumn("File", ImGuiTableColumnFlags_WidthStretch);
                 ImGui::TableSetupColumn("From", ImGuiTableColumnFlags_WidthStretch);
                 ImGui::TableSetupColumn("To",   ImGuiTableColumnFlags_WidthStretch);
                 ImGui::TableSetupColumn("Status", ImGuiTableColumnFlags_WidthFixed, 60.0f);
                 ImGui::TableSetupColumn("Progress", ImGuiTableColumnFlags_WidthFixed, 100.0f);
+                ImGui::TableSetupColumn("Speed", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+                ImGui::TableSetupColumn("ETA", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+                ImGui::TableSetupScrollFreeze(0, 1);
                 ImGui::TableHeadersRow();
 
-                for (int i = 0; i < queue.size(); i++) {
-                    auto job = queue[i];
-                    ImGui::PushID(i);
-                    ImGui::TableNextRow();
+                // Only the visible rows are submitted; cost is independent of the queue length
+                ImGuiListClipper clipper;
+                clipper.Begin((int)queue.size());
+                while (clipper.Step()) {
+                    for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                        const auto& job = queue[i];
+                        ImGui::PushID(i);
+                        ImGui::TableNextRow();
                     
-                    ImGui::TableSetColumnIndex(0);
-                    std::string typeLabel = (job->type == JobType::Copy) ? "COPY" : "MOVE";
-                    ImVec4 typeColor = (job->type == JobType::Copy) ? ImVec4(0.4f, 0.8f, 1.0f, 1) : ImVec4(1.0f, 0.6f, 0.2f, 1);
-                    ImGui::PushStyleColor(ImGuiCol_Text, typeColor);
-                    if (ImGui::Selectable(typeLabel.c_str(), selectedQueueIndex == i, ImGuiSelectableFlags_SpanAllColumns)) {
-                        selectedQueueIndex = i;
-                    }
-                    ImGui::PopStyleColor();
-
-                    ImGui::TableSetColumnIndex(1); ImGui::Text("%s", job->source.filename().string().c_str());
-                    ImGui::TableSetColumnIndex(2); ImGui::Text("%s", job->source.parent_path().string().c_str());
-                    ImGui::TableSetColumnIndex(3); ImGui::Text("%s", job->destination.parent_path().string().c_str());
+                        ImGui::TableSetColumnIndex(0);
+                        const char* typeLabel = "COPY";
+                        ImVec4 typeColor = ImVec4(0.4f, 0.8f, 1.0f, 1);
+                        if (job->type == JobType::Move) { typeLabel = "MOVE"; typeColor = ImVec4(1.0f, 0.6f, 0.2f, 1); }
+                        else if (job->type == JobType::Sync) { typeLabel = "SYNC"; typeColor = ImVec4(0.6f, 1.0f, 0.6f, 1); }
+                        ImGui::PushStyleColor(ImGuiCol_Text, typeColor);
+                        if (ImGui::Selectable(typeLabel, selectedQueueIndex == i, ImGuiSelectableFlags_SpanAllColumns)) {
+                            selectedQueueIndex = i;
+                        }
+                        ImGui::PopStyleColor();
+
+                        ImGui::TableSetColumnIndex(1); ImGui::TextUnformatted(job->displayName);
+                        ImGui::TableSetColumnIndex(2); ImGui::TextUnformatted(job->displayFrom);
+                        ImGui::TableSetColumnIndex(3); ImGui::TextUnformatted(job->displayTo);
                     
-                    ImGui::TableSetColumnIndex(4);
-                    const char* statusStr = "...";
-                    ImVec4 color = ImVec4(1,1,1,1);
-                    switch(job->status.load()) {
-                        case JobStatus::Pending:    statusStr = "WAIT"; color = ImVec4(0.5,0.5,0.5,1); break;
-                        case JobStatus::Calculating:statusStr = "SCAN"; color = ImVec4(0,0.8,0.8,1); break;
-                        case JobStatus::Copying:    statusStr = "BUSY"; color = ImVec4(0,1,1,1); break;
-                        case JobStatus::Paused:     statusStr = "PAUSE"; color = ImVec4(1,1,0,1); break;
-                        case JobStatus::Completed:  statusStr = "DONE"; color = ImVec4(0,1,0,1); break;
-                        case JobStatus::Failed:     statusStr = "ERR"; color = ImVec4(1,0,0,1); break;
+                        ImGui::TableSetColumnIndex(4);
+                        const char* statusStr = "...";
+                        ImVec4 color = ImVec4(1,1,1,1);
+                        switch(job->status.load()) {
+                            case JobStatus::Pending:    statusStr = "WAIT"; color = ImVec4(0.5,0.5,0.5,1); break;
+                            case JobStatus::Calculating:statusStr = "SCAN"; color = ImVec4(0,0.8,0.8,1); break;
+                            case JobStatus::Copying:    statusStr = "BUSY"; color = ImVec4(0,1,1,1); break;
+                            case JobStatus::Deleting:   statusStr = "DEL"; color = ImVec4(1.0f,0.6f,0.2f,1); break;
+                            case JobStatus::Paused:     statusStr = "PAUSE"; color = ImVec4(1,1,0,1); break;
+                            case JobStatus::Completed:  statusStr = job->filesVerified > 0 ? "VRFD" : "DONE"; color = ImVec4(0,1,0,1); break;
+                            case JobStatus::Failed:     statusStr = "ERR"; color = ImVec4(1,0,0,1); break;
+                        }
+                        ImGui::TextColored(color, statusStr);
+
+                        ImGui::TableSetColumnIndex(5);
+                        ImGui::ProgressBar(job->progress, ImVec2(-1, 0), ""); 
+
+                        char speed[32], eta[32];
+                        FormatJobRate(*job, speed, eta);
+                        ImGui::TableSetColumnIndex(6); ImGui::TextUnformatted(speed);
+                        ImGui::TableSetColumnIndex(7); ImGui::TextUnformatted(eta);
+                        ImGui::PopID(); 
                     }
-                    ImGui::TextColored(color, statusStr);
-
-                    ImGui::TableSetColumnIndex(5);
-                    ImGui::ProgressBar(job->progress, ImVec2(-1, 0), ""); 
-                    ImGui::PopID(); 
                 }
                 ImGui::EndTable();
             }
@@ -214,13 +317,25 @@ int main(int, char**)
              if (transferManager.IsPaused()) transferManager.ResumeQueue();
              else transferManager.PauseQueue();
         }
+
+        // Bandwidth caps in MB/s; 0 lifts them. Both apply to running jobs immediately.
+        ImGui::Spacing();
+        ImGui::TextUnformatted("Limit all (MB/s)");
+        ImGui::SetNextItemWidth(-1);
+        if (ImGui::InputInt("##GlobalLimit", &globalLimitMb, 10, 100)) {
+            globalLimitMb = std::max(globalLimitMb, 0);
+            transferManager.SetGlobalBandwidthLimit(static_cast<uint64_t>(globalLimitMb) * 1024 * 1024);
+        }
+        ImGui::Checkbox("Performance", &showPerformance);
+        ImGui::Checkbox("Low power", &lowPowerRendering);
         
         ImGui::Spacing();
         ImGui::Separator();
         ImGui::Spacing();
 
         bool hasSelection = (selectedQueueIndex >= 0 && selectedQueueIndex < queue.size());
-        bool busy = (hasSelection && queue[selectedQueueIndex]->status == JobStatus::Copying);
+        JobStatus selectedStatus = hasSelection ? queue[selectedQueueIndex]->status.load() : JobStatus::Pending;
+        bool busy = (selectedStatus == JobStatus::Copying || selectedStatus == JobStatus::Deleting);
 
         if (!hasSelection || busy) ImGui::BeginDisabled();
         if (ImGui::Button("REMOVE ITEM", ImVec2(-1, 30))) {
@@ -229,12 +344,24 @@ int main(int, char**)
         }
         if (!hasSelection || busy) ImGui::EndDisabled();
 
+        if (hasSelection) {
+            FileJob& selected = *queue[selectedQueueIndex];
+            int jobLimitMb = static_cast<int>(selected.bandwidth.GetRate() / (1024 * 1024));
+            ImGui::TextUnformatted("Limit job (MB/s)");
+            ImGui::SetNextItemWidth(-1);
+            if (ImGui::InputInt("##JobLimit", &jobLimitMb, 10, 100)) {
+                selected.bandwidth.SetRate(static_cast<uint64_t>(std::max(jobLimitMb, 0)) * 1024 * 1024);
+            }
+        }
+
         ImGui::Spacing();
         if (!hasSelection) ImGui::TextWrapped("Select a job to remove it");
 
         ImGui::EndChild();
         ImGui::End(); 
 
+        if (showPerformance) performancePanel.Render(&showPerformance);
+
         ImGui::Render();
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
@@ -242,8 +369,26 @@ int main(int, char**)
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+        // Pick the next wait: poll while the user interacts or a listing streams in,
+        // throttle while only progress moves, otherwise sleep until something happens.
+        // The wake flag goes up before the queue is inspected, so a change that lands in
+        // between still ends the sleep.
+        g_wakeOnQueueChange = true;
+        const bool interactive = glfwGetTime() - g_lastInputTime < kInteractiveSeconds || ImGui::IsAnyItemActive() ||
+                                 leftBrowser.IsLoading() || rightBrowser.IsLoading();
+        if (!lowPowerRendering || interactive) frameTimeout = 0.0;
+        else if (transferManager.IsRunning() && !transferManager.IsPaused()) frameTimeout = kProgressFrameSeconds;
+        else frameTimeout = kIdleFrameSeconds;
+        g_wakeOnQueueChange = (frameTimeout == kIdleFrameSeconds);
+
+        // The swap waits for vsync, so it is left out of the frame's CPU time
+        Profiler::RecordSince(ProfileStage::Frame, frameStart);
+        performancePanel.AddFrame(Profiler::Now() - frameStart, frameStart - previousFrameStart);
+        previousFrameStart = frameStart;
         glfwSwapBuffers(window);
     }
+    transferManager.SetStateObserver(nullptr);
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -252,5 +397,7 @@ int main(int, char**)
     glfwTerminate();
     CoUninitialize();
 
+    ButlerLogger::Log("Application Exiting...");
+    ButlerLogger::Shutdown();
     return 0;
 }
\ No newline at end of file